@@ -0,0 +1,56 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <atomic>     // std::atomic
+#include <cstdint>    // std::uint64_t
+#include <functional> // std::function
+#include <limits>     // std::numeric_limits
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+namespace bench {
+/// Number of calls of the global operator new. Counted by main.cpp.
+inline std::atomic<std::uint64_t> n_allocations{0};
+
+/**
+ * One benchmark. The function sets up and runs a model and returns the number
+ * of processed events.
+ */
+struct benchmark {
+  /// Name of the benchmark.
+  std::string name_;
+
+  /// Function running the benchmark.
+  std::function<std::uint64_t()> run_;
+};
+
+/**
+ * Run a simulation until the target time is reached or no more events are
+ * scheduled, counting the processed events.
+ *
+ * @tparam Simulation Simulation type.
+ * @tparam Time Type used for simulation time.
+ * @param sim Reference to the simulation.
+ * @param target Target time.
+ * @return Number of processed events.
+ */
+template <typename Simulation, typename Time = double>
+std::uint64_t run(Simulation &sim,
+                  Time target = std::numeric_limits<Time>::infinity()) {
+  std::uint64_t n = 0;
+  while (!sim.empty() && sim.next_time() < target) {
+    sim.step();
+    ++n;
+  }
+
+  return n;
+}
+
+/// @param benchmarks Benchmarks to add the microbenchmarks to.
+void add_micro(std::vector<benchmark> &benchmarks);
+
+/// @param benchmarks Benchmarks to add the models derived from the examples to.
+void add_macro(std::vector<benchmark> &benchmarks);
+} // namespace bench
@@ -0,0 +1,181 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Models of the examples without output, scaled to many more entities.
+
+#include <algorithm> // std::max
+#include <cstdint>   // std::uint64_t
+#include <random>    // std::default_random_engine, ...
+#include <vector>    // std::vector
+
+#include "benchmark.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+namespace {
+namespace carwash {
+struct config {
+  double wash_time;
+  simcpp20::resource<> machines;
+  std::uniform_real_distribution<> arrival_time_dist;
+  std::default_random_engine gen;
+};
+
+simcpp20::event<> car(simcpp20::simulation<> &sim, config &conf) {
+  co_await conf.machines.request();
+  co_await sim.timeout(conf.wash_time);
+  conf.machines.release();
+}
+
+simcpp20::event<> car_source(simcpp20::simulation<> &sim, config &conf) {
+  while (true) {
+    co_await sim.timeout(conf.arrival_time_dist(conf.gen));
+    car(sim, conf);
+  }
+}
+
+std::uint64_t run() {
+  simcpp20::simulation<> sim;
+  config conf{
+      .wash_time = 5,
+      .machines = simcpp20::resource<>{sim, 100},
+      .arrival_time_dist = std::uniform_real_distribution<>{0.03, 0.07},
+      .gen = std::default_random_engine{42},
+  };
+
+  car_source(sim, conf);
+  return bench::run(sim, 10'000.);
+}
+} // namespace carwash
+
+namespace bank_renege {
+struct config {
+  int n_customers;
+  simcpp20::resource<> counters;
+  std::uniform_real_distribution<> max_wait_time_dist;
+  std::exponential_distribution<> arrival_interval_dist;
+  std::exponential_distribution<> service_time_dist;
+  std::default_random_engine gen;
+};
+
+simcpp20::event<> customer(simcpp20::simulation<> &sim, config &conf) {
+  auto request = conf.counters.request();
+  co_await (request | sim.timeout(conf.max_wait_time_dist(conf.gen)));
+
+  if (!request.triggered()) {
+    request.abort();
+    co_return;
+  }
+
+  co_await sim.timeout(conf.service_time_dist(conf.gen));
+  conf.counters.release();
+}
+
+simcpp20::event<> customer_source(simcpp20::simulation<> &sim, config &conf) {
+  for (int id = 1; id <= conf.n_customers; ++id) {
+    customer(sim, conf);
+    co_await sim.timeout(conf.arrival_interval_dist(conf.gen));
+  }
+}
+
+std::uint64_t run() {
+  simcpp20::simulation<> sim;
+  config conf{
+      .n_customers = 200'000,
+      .counters = simcpp20::resource<>{sim, 50},
+      .max_wait_time_dist = std::uniform_real_distribution<>{1., 3.},
+      .arrival_interval_dist = std::exponential_distribution<>{50. / 10},
+      .service_time_dist = std::exponential_distribution<>{1. / 12},
+      .gen = std::default_random_engine{42},
+  };
+
+  customer_source(sim, conf);
+  return bench::run(sim);
+}
+} // namespace bank_renege
+
+namespace machine_shop {
+struct config {
+  double repair_time;
+  double job_duration;
+  simcpp20::preemptive_resource<> repair_man;
+  std::normal_distribution<> time_for_part_dist;
+  std::exponential_distribution<> time_to_failure_dist;
+  std::default_random_engine gen;
+};
+
+class machine {
+public:
+  machine(simcpp20::simulation<> &sim, config &conf)
+      : sim{sim}, conf{conf}, working{produce()} {
+    fail();
+  }
+
+  simcpp20::simulation<> &sim;
+
+private:
+  simcpp20::process<> produce() {
+    while (true) {
+      double time_for_part = std::max(0., conf.time_for_part_dist(conf.gen));
+
+      while (time_for_part > 0) {
+        double start = sim.now();
+        auto result = co_await sim.delay(time_for_part);
+        if (!result.interrupted()) {
+          break;
+        }
+
+        broken = true;
+        time_for_part = std::max(0., time_for_part - (sim.now() - start));
+
+        auto request = conf.repair_man.request(working, 1);
+        co_await request;
+        co_await sim.delay(conf.repair_time);
+        conf.repair_man.release(request);
+        broken = false;
+      }
+    }
+  }
+
+  simcpp20::event<> fail() {
+    while (true) {
+      co_await sim.delay(conf.time_to_failure_dist(conf.gen));
+      if (!broken) {
+        working.interrupt();
+      }
+    }
+  }
+
+  config &conf;
+  bool broken = false;
+  simcpp20::process<> working;
+};
+
+std::uint64_t run() {
+  simcpp20::simulation<> sim;
+  config conf{
+      .repair_time = 30,
+      .job_duration = 30,
+      .repair_man = simcpp20::preemptive_resource<>{sim, 10},
+      .time_for_part_dist = std::normal_distribution<>{10, 2},
+      .time_to_failure_dist = std::exponential_distribution<>{1. / 300},
+      .gen = std::default_random_engine{42},
+  };
+
+  std::vector<machine> machines;
+  machines.reserve(100);
+  for (int i = 0; i < 100; ++i) {
+    machines.emplace_back(sim, conf);
+  }
+
+  return bench::run(sim, 52. * 7 * 24 * 60);
+}
+} // namespace machine_shop
+} // namespace
+
+namespace bench {
+void add_macro(std::vector<benchmark> &benchmarks) {
+  benchmarks.push_back({"carwash", carwash::run});
+  benchmarks.push_back({"bank_renege", bank_renege::run});
+  benchmarks.push_back({"machine_shop", machine_shop::run});
+}
+} // namespace bench
@@ -0,0 +1,67 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+// Runs all benchmarks whose name contains the first argument, if any, and
+// prints the processed events per second and heap allocations per event of
+// the fastest of three runs each.
+
+#include <algorithm> // std::max
+#include <chrono>    // std::chrono::steady_clock, std::chrono::duration
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+#include <cstdio>    // std::printf
+#include <cstdlib>   // std::malloc, std::free
+#include <new>       // std::bad_alloc
+#include <string>    // std::string
+#include <vector>    // std::vector
+
+#include "benchmark.hpp"
+
+void *operator new(std::size_t size) {
+  bench::n_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+int main(int argc, char **argv) {
+  std::vector<bench::benchmark> benchmarks;
+  bench::add_micro(benchmarks);
+  bench::add_macro(benchmarks);
+
+  std::string filter = argc > 1 ? argv[1] : "";
+
+  std::printf("%-32s %12s %12s %12s\n", "benchmark", "events", "Mevents/s",
+              "allocs/event");
+  for (auto &b : benchmarks) {
+    if (b.name_.find(filter) == std::string::npos) {
+      continue;
+    }
+
+    double best = 0;
+    std::uint64_t n_events = 0;
+    std::uint64_t n_allocations = 0;
+    for (int rep = 0; rep < 3; ++rep) {
+      auto allocations_before = bench::n_allocations.load();
+      auto start = std::chrono::steady_clock::now();
+      n_events = b.run_();
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      n_allocations = bench::n_allocations.load() - allocations_before;
+
+      double rate = static_cast<double>(n_events) / elapsed.count();
+      best = std::max(best, rate);
+    }
+
+    std::printf("%-32s %12llu %12.2f %12.3f\n", b.name_.c_str(),
+                static_cast<unsigned long long>(n_events), best / 1e6,
+                static_cast<double>(n_allocations) /
+                    static_cast<double>(std::max<std::uint64_t>(n_events, 1)));
+  }
+}
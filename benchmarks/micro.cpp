@@ -0,0 +1,185 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <array>   // std::array
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <random>  // std::default_random_engine, ...
+#include <string>  // std::to_string
+#include <vector>  // std::vector
+
+#include "benchmark.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+namespace {
+/// Total number of events of the microbenchmarks, roughly.
+constexpr std::uint64_t n_events = 1'000'000;
+
+simcpp20::event<> hold(simcpp20::simulation<> &sim, std::uint64_t n,
+                       unsigned seed) {
+  std::default_random_engine gen{seed};
+  std::exponential_distribution<> dist{1};
+  for (std::uint64_t i = 0; i < n; ++i) {
+    co_await sim.delay(dist(gen));
+  }
+}
+
+/// Schedule and step with a stable number of scheduled events.
+std::uint64_t hold_model(std::size_t queue_size) {
+  simcpp20::simulation<> sim;
+  for (std::size_t i = 0; i < queue_size; ++i) {
+    hold(sim, n_events / queue_size, static_cast<unsigned>(i));
+  }
+
+  return bench::run(sim);
+}
+
+simcpp20::event<std::uint64_t>
+hold_ticks(simcpp20::simulation<std::uint64_t> &sim, std::uint64_t n,
+           unsigned seed) {
+  std::default_random_engine gen{seed};
+  std::exponential_distribution<> dist{1e-6};
+  for (std::uint64_t i = 0; i < n; ++i) {
+    co_await sim.delay(static_cast<std::uint64_t>(dist(gen)));
+  }
+}
+
+/// Like hold_model, but with integral time, which uses a radix heap.
+std::uint64_t hold_ticks_model(std::size_t queue_size) {
+  simcpp20::simulation<std::uint64_t> sim;
+  for (std::size_t i = 0; i < queue_size; ++i) {
+    hold_ticks(sim, n_events / queue_size, static_cast<unsigned>(i));
+  }
+
+  return bench::run(sim);
+}
+
+/// Schedule many timeouts at once, then process all of them.
+std::uint64_t schedule_drain(std::size_t queue_size) {
+  simcpp20::simulation<> sim;
+  std::default_random_engine gen{42};
+  std::exponential_distribution<> dist{1};
+
+  std::uint64_t n = 0;
+  for (std::uint64_t round = 0; round < n_events / queue_size; ++round) {
+    for (std::size_t i = 0; i < queue_size; ++i) {
+      sim.timeout(dist(gen));
+    }
+
+    n += bench::run(sim);
+  }
+
+  return n;
+}
+
+simcpp20::event<> churn(simcpp20::simulation<> &sim, std::uint64_t n) {
+  for (std::uint64_t i = 0; i < n; ++i) {
+    // a timeout which is aborted before it is processed, like a renege
+    auto patience = sim.timeout(100);
+    co_await sim.timeout(1);
+    patience.abort();
+  }
+}
+
+/// Create and abort timeouts.
+std::uint64_t timeout_churn() {
+  simcpp20::simulation<> sim;
+  for (int i = 0; i < 100; ++i) {
+    churn(sim, n_events / 100);
+  }
+
+  return bench::run(sim);
+}
+
+simcpp20::event<> fan_in(simcpp20::simulation<> &sim, std::uint64_t n,
+                         std::size_t width, bool all) {
+  std::vector<simcpp20::event<>> evs(width, sim.event());
+  for (std::uint64_t i = 0; i < n; ++i) {
+    for (std::size_t j = 0; j < width; ++j) {
+      evs[j] = sim.timeout(static_cast<double>(j + 1));
+    }
+
+    if (all) {
+      co_await sim.all_of(evs);
+    } else {
+      co_await sim.any_of(evs);
+    }
+  }
+}
+
+/// Wait for conditions of several timeouts.
+std::uint64_t condition(std::size_t width, bool all) {
+  simcpp20::simulation<> sim;
+  for (int i = 0; i < 100; ++i) {
+    fan_in(sim, n_events / 100 / width, width, all);
+  }
+
+  return bench::run(sim);
+}
+
+simcpp20::event<> child(simcpp20::simulation<> &sim) { co_await sim.delay(1); }
+
+simcpp20::event<> spawner(simcpp20::simulation<> &sim, std::uint64_t n) {
+  for (std::uint64_t i = 0; i < n; ++i) {
+    child(sim);
+    co_await sim.delay(1);
+  }
+}
+
+/// Start short-lived processes.
+std::uint64_t spawn() {
+  simcpp20::simulation<> sim;
+  for (int i = 0; i < 100; ++i) {
+    spawner(sim, n_events / 100 / 3);
+  }
+
+  return bench::run(sim);
+}
+
+template <std::size_t Size>
+simcpp20::event<> consume(simcpp20::simulation<> &sim, std::uint64_t n) {
+  std::uint64_t sum = 0;
+  for (std::uint64_t i = 0; i < n; ++i) {
+    auto payload = co_await sim.timeout<std::array<char, Size>>(1);
+    sum += static_cast<std::uint64_t>(payload[0]);
+  }
+}
+
+/// Process value events with payloads of the given size.
+template <std::size_t Size> std::uint64_t payload() {
+  simcpp20::simulation<> sim;
+  for (int i = 0; i < 100; ++i) {
+    consume<Size>(sim, n_events / 100);
+  }
+
+  return bench::run(sim);
+}
+} // namespace
+
+namespace bench {
+void add_micro(std::vector<benchmark> &benchmarks) {
+  for (std::size_t queue_size : {100, 10'000, 1'000'000}) {
+    auto size = std::to_string(queue_size);
+    benchmarks.push_back({"hold/" + size, [=] { return hold_model(queue_size); }});
+    benchmarks.push_back(
+        {"hold_ticks/" + size, [=] { return hold_ticks_model(queue_size); }});
+    benchmarks.push_back(
+        {"schedule_drain/" + size, [=] { return schedule_drain(queue_size); }});
+  }
+
+  benchmarks.push_back({"timeout_churn", timeout_churn});
+
+  for (std::size_t width : {2, 8, 32}) {
+    auto size = std::to_string(width);
+    benchmarks.push_back(
+        {"any_of/" + size, [=] { return condition(width, false); }});
+    benchmarks.push_back(
+        {"all_of/" + size, [=] { return condition(width, true); }});
+  }
+
+  benchmarks.push_back({"spawn", spawn});
+  benchmarks.push_back({"value_event/8", payload<8>});
+  benchmarks.push_back({"value_event/64", payload<64>});
+  benchmarks.push_back({"value_event/512", payload<512>});
+}
+} // namespace bench
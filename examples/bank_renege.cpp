@@ -3,15 +3,15 @@
 
 // See https://simpy.readthedocs.io/en/latest/examples/bank_renege.html
 
+#include <cstdint>
 #include <cstdio>
 #include <random>
 
 #include "fschuetz04/simcpp20.hpp"
-#include "resource.hpp"
 
 struct config {
   int n_customers;
-  resource counters;
+  simcpp20::resource<> counters;
   std::uniform_real_distribution<> max_wait_time_dist;
   std::exponential_distribution<> arrival_interval_dist;
   std::exponential_distribution<> service_time_dist;
@@ -39,27 +39,24 @@ simcpp20::event<> customer(simcpp20::simulation<> &sim, config &conf, int id) {
   conf.counters.release();
 }
 
-simcpp20::event<> customer_source(simcpp20::simulation<> &sim, config &conf) {
-  for (int id = 1; id <= conf.n_customers; ++id) {
-    customer(sim, conf, id);
-    co_await sim.timeout(conf.arrival_interval_dist(conf.gen));
-  }
-}
-
 int main() {
   simcpp20::simulation<> sim;
 
   std::random_device rd;
   config conf{
       .n_customers = 5,
-      .counters = resource{sim, 1},
+      .counters = simcpp20::resource<>{sim, 1},
       .max_wait_time_dist = std::uniform_real_distribution<>{1., 3.},
       .arrival_interval_dist = std::exponential_distribution<>{1. / 10},
       .service_time_dist = std::exponential_distribution<>{1. / 12},
       .gen = std::default_random_engine{rd()},
   };
 
-  customer_source(sim, conf);
+  sim.arrivals(conf.arrival_interval_dist, conf.gen,
+               [&](std::uint64_t i) {
+                 customer(sim, conf, static_cast<int>(i) + 1);
+               },
+               static_cast<std::uint64_t>(conf.n_customers));
 
   sim.run();
 }
@@ -9,7 +9,7 @@ simcpp20::event<> clock_proc(simcpp20::simulation<> &sim, char const *name,
                              double delay) {
   while (true) {
     printf("[%.0f] %s\n", sim.now(), name);
-    co_await sim.timeout(delay);
+    co_await sim.delay(delay);
   }
 }
 
@@ -6,14 +6,15 @@
 // TODO(fschuetz04): Memory leak
 
 #include "fschuetz04/simcpp20.hpp"
-#include "resource.hpp"
 
+#include <algorithm>
 #include <cstdio>
 #include <random>
 
 struct config {
   double repair_time;
-  resource repair_man;
+  double job_duration;
+  simcpp20::preemptive_resource<> repair_man;
   std::normal_distribution<> time_for_part_dist;
   std::exponential_distribution<> time_to_failure_dist;
   std::default_random_engine gen;
@@ -22,8 +23,7 @@ struct config {
 class machine {
 public:
   machine(simcpp20::simulation<> &sim, config &conf)
-      : sim{sim}, conf{conf}, failure{sim.event()} {
-    produce();
+      : sim{sim}, conf{conf}, working{produce()} {
     fail();
   }
 
@@ -31,49 +31,81 @@ public:
   simcpp20::simulation<> &sim;
 
 private:
-  simcpp20::event<> produce() {
+  simcpp20::process<> produce() {
     while (true) {
-      double time_for_part = conf.time_for_part_dist(conf.gen);
+      double time_for_part = std::max(0., conf.time_for_part_dist(conf.gen));
 
-      while (true) {
+      while (time_for_part > 0) {
         double start = sim.now();
-        auto timeout = sim.timeout(time_for_part);
-        co_await(timeout | failure);
-
-        if (timeout.triggered()) {
+        auto result = co_await sim.delay(time_for_part);
+        if (!result.interrupted()) {
           // part is finished
-          ++n_parts_made;
           break;
         }
 
         // machine failed, calculate remaining time for part and wait for repair
-        time_for_part -= sim.now() - start;
-        co_await conf.repair_man.request();
-        co_await sim.timeout(conf.repair_time);
-        conf.repair_man.release();
+        broken = true;
+        time_for_part = std::max(0., time_for_part - (sim.now() - start));
+
+        auto request = conf.repair_man.request(working, 1);
+        co_await request;
+        co_await sim.delay(conf.repair_time);
+        conf.repair_man.release(request);
+        broken = false;
       }
+
+      ++n_parts_made;
     }
   }
 
   simcpp20::event<> fail() {
     while (true) {
-      co_await sim.timeout(conf.time_to_failure_dist(conf.gen));
-      failure.trigger();
-      failure = sim.event();
+      co_await sim.delay(conf.time_to_failure_dist(conf.gen));
+      if (!broken) {
+        working.interrupt();
+      }
     }
   }
 
   config &conf;
-  simcpp20::event<> failure;
+  bool broken = false;
+  simcpp20::process<> working;
 };
 
+simcpp20::event<> other_jobs(simcpp20::simulation<> &sim, config &conf) {
+  while (true) {
+    double time_for_job = conf.job_duration;
+
+    while (time_for_job > 0) {
+      // preempted by repairs of the machines
+      auto preempted = sim.event();
+      auto request = conf.repair_man.request(
+          2, true, [preempted](const auto &) { preempted.trigger(); });
+      co_await request;
+
+      double start = sim.now();
+      auto finished = sim.timeout(time_for_job);
+      co_await (finished | preempted);
+      if (finished.processed()) {
+        // job is finished
+        conf.repair_man.release(request);
+        break;
+      }
+
+      finished.abort();
+      time_for_job = std::max(0., time_for_job - (sim.now() - start));
+    }
+  }
+}
+
 int main() {
   simcpp20::simulation<> sim;
 
   std::random_device rd;
   config conf{
       .repair_time = 30,
-      .repair_man = resource{sim, 1},
+      .job_duration = 30,
+      .repair_man = simcpp20::preemptive_resource<>{sim, 1},
       .time_for_part_dist = std::normal_distribution<>{10, 2},
       .time_to_failure_dist = std::exponential_distribution<>{1. / 300},
       .gen = std::default_random_engine{rd()},
@@ -86,6 +118,8 @@ int main() {
     machines.emplace_back(sim, conf);
   }
 
+  other_jobs(sim, conf);
+
   int n_weeks = 4;
   sim.run_until(n_weeks * 7 * 24 * 60);
 
@@ -3,4 +3,12 @@
 
 #pragma once
 
+#include "simcpp20/container.hpp"
+#include "simcpp20/instantiations.hpp"
+#include "simcpp20/process.hpp"
+#include "simcpp20/random.hpp"
+#include "simcpp20/replication.hpp"
+#include "simcpp20/resource.hpp"
+#include "simcpp20/run_control.hpp"
 #include "simcpp20/simulation.hpp"
+#include "simcpp20/store.hpp"
@@ -0,0 +1,245 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm> // std::max
+#include <array>     // std::array
+#include <cassert>   // assert
+#include <cstddef>   // std::size_t, std::max_align_t
+#include <cstdint>   // std::uintptr_t
+#include <new>       // operator new, operator delete, std::align_val_t
+#include <utility>   // std::swap
+#include <vector>    // std::vector
+
+/*
+ * Forces inlining of the operator delete of the promise types. Otherwise, GCC
+ * pairs the call of it with the call of the templated operator new in
+ * unoptimized builds and reports -Wmismatched-new-delete, although both use
+ * the allocator of the simulation.
+ */
+#if defined(__GNUC__)
+#define SIMCPP20_FRAME_DELETE [[gnu::always_inline]]
+#else
+#define SIMCPP20_FRAME_DELETE
+#endif
+
+namespace simcpp20 {
+/// Allocator using the global operator new and operator delete.
+class heap_allocator {
+public:
+  /**
+   * @param size Size of the memory block in bytes.
+   * @return Pointer to the allocated memory block.
+   */
+  void *allocate(std::size_t size) { return ::operator new(size); }
+
+  /**
+   * @param ptr Pointer to a memory block returned by allocate.
+   * @param size Size of the memory block in bytes.
+   */
+  void deallocate(void *ptr, std::size_t size) {
+    ::operator delete(ptr, size);
+  }
+};
+
+/**
+ * Allocator recycling memory blocks in free lists, one per size class.
+ *
+ * Blocks are carved from large chunks, which are only returned to the system
+ * when the allocator is destroyed. Thus, once the number of live blocks of a
+ * size class reached its maximum, allocating and deallocating a block does not
+ * allocate heap memory anymore. Blocks larger than max_size are allocated
+ * using the global operator new.
+ *
+ * Not thread-safe. Each simulation owns its own allocator, which may borrow
+ * the memory of a parent allocator, so consecutive simulations on one thread
+ * reuse their blocks and chunks.
+ */
+class pool_allocator {
+public:
+  /// Alignment and size granularity of all blocks.
+  static constexpr std::size_t granularity = alignof(std::max_align_t);
+
+  /// Maximum size of a block served from the free lists.
+  static constexpr std::size_t max_size = 1024;
+
+  /// Size of one chunk blocks are carved from.
+  static constexpr std::size_t chunk_size = 64 * 1024;
+
+  /// Constructor.
+  pool_allocator() = default;
+
+  /**
+   * Constructor. Borrow all memory of a parent allocator, which is returned to
+   * the parent once this allocator is destroyed.
+   *
+   * @param parent Parent allocator. Must outlive this allocator and must not
+   * be used until this allocator is destroyed.
+   */
+  explicit pool_allocator(pool_allocator *parent) : parent_{parent} {
+    swap(*parent_);
+  }
+
+  pool_allocator(const pool_allocator &) = delete;
+  pool_allocator &operator=(const pool_allocator &) = delete;
+
+  /// Destructor. Return all memory to the parent allocator, if any.
+  ~pool_allocator() {
+    if (parent_ != nullptr) {
+      swap(*parent_);
+      return;
+    }
+
+    for (auto chunk : chunks_) {
+      ::operator delete(chunk);
+    }
+  }
+
+  /**
+   * @param size Size of the memory block in bytes.
+   * @return Pointer to the allocated memory block.
+   */
+  void *allocate(std::size_t size) {
+    if (size > max_size) {
+      return ::operator new(size);
+    }
+
+    auto &free_list = free_lists_[size_class(size)];
+    if (free_list != nullptr) {
+      auto block = free_list;
+      free_list = block->next_;
+      return block;
+    }
+
+    std::size_t block_size = (size_class(size) + 1) * granularity;
+    if (static_cast<std::size_t>(end_ - cursor_) < block_size) {
+      cursor_ = static_cast<char *>(::operator new(chunk_size));
+      end_ = cursor_ + chunk_size;
+      chunks_.push_back(cursor_);
+    }
+
+    void *ptr = cursor_;
+    cursor_ += block_size;
+    return ptr;
+  }
+
+  /**
+   * @param ptr Pointer to a memory block returned by allocate.
+   * @param size Size of the memory block in bytes.
+   */
+  void deallocate(void *ptr, std::size_t size) {
+    if (size > max_size) {
+      ::operator delete(ptr, size);
+      return;
+    }
+
+    auto &free_list = free_lists_[size_class(size)];
+    auto block = static_cast<free_block *>(ptr);
+    block->next_ = free_list;
+    free_list = block;
+  }
+
+private:
+  /// Unused memory block in a free list.
+  struct free_block {
+    /// Next unused memory block of the same size class.
+    free_block *next_;
+  };
+
+  /// @param other Allocator to exchange all memory with.
+  void swap(pool_allocator &other) {
+    std::swap(free_lists_, other.free_lists_);
+    std::swap(chunks_, other.chunks_);
+    std::swap(cursor_, other.cursor_);
+    std::swap(end_, other.end_);
+  }
+
+  /**
+   * @param size Size of the memory block in bytes. Must not be larger than
+   * max_size.
+   * @return Index of the size class.
+   */
+  static std::size_t size_class(std::size_t size) {
+    return size == 0 ? 0 : (size - 1) / granularity;
+  }
+
+  /// Free lists, one per size class.
+  std::array<free_block *, max_size / granularity> free_lists_{};
+
+  /// Allocated chunks.
+  std::vector<char *> chunks_{};
+
+  /// Start of unused memory in the current chunk.
+  char *cursor_ = nullptr;
+
+  /// End of the current chunk.
+  char *end_ = nullptr;
+
+  /// Parent allocator to return all memory to, or nullptr.
+  pool_allocator *parent_ = nullptr;
+};
+
+/**
+ * Alignment of coroutine frames. The compiler expects the alignment guaranteed
+ * by the global operator new, since the operator new of a promise type does
+ * not receive the alignment of the frame.
+ */
+inline constexpr std::size_t frame_alignment =
+    __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+/**
+ * Allocate a coroutine frame. A pointer to the allocator is stored in front of
+ * the frame, since the operator delete of a promise type does not receive the
+ * arguments of the coroutine function.
+ *
+ * Allocators only guarantee fundamental alignment. If frames need more, which
+ * is not the case on common platforms, they are allocated using the aligned
+ * global operator new instead.
+ *
+ * @tparam Allocator Allocator type.
+ * @param allocator Pointer to the allocator.
+ * @param size Size of the coroutine frame in bytes.
+ * @return Pointer to the coroutine frame.
+ */
+template <typename Allocator>
+void *allocate_frame(Allocator *allocator, std::size_t size) {
+  constexpr std::size_t header_size =
+      std::max(frame_alignment, alignof(std::max_align_t));
+  static_assert(sizeof(Allocator *) <= header_size);
+
+  void *block = nullptr;
+  if constexpr (frame_alignment > alignof(std::max_align_t)) {
+    block = ::operator new(header_size + size, std::align_val_t{header_size});
+  } else {
+    block = allocator->allocate(header_size + size);
+  }
+
+  *static_cast<Allocator **>(block) = allocator;
+  void *frame = static_cast<char *>(block) + header_size;
+  assert(reinterpret_cast<std::uintptr_t>(frame) % frame_alignment == 0);
+  return frame;
+}
+
+/**
+ * Deallocate a coroutine frame allocated using allocate_frame.
+ *
+ * @tparam Allocator Allocator type.
+ * @param frame Pointer to the coroutine frame.
+ * @param size Size of the coroutine frame in bytes.
+ */
+template <typename Allocator>
+void deallocate_frame(void *frame, std::size_t size) {
+  constexpr std::size_t header_size =
+      std::max(frame_alignment, alignof(std::max_align_t));
+
+  void *block = static_cast<char *>(frame) - header_size;
+  if constexpr (frame_alignment > alignof(std::max_align_t)) {
+    ::operator delete(block, header_size + size,
+                      std::align_val_t{header_size});
+  } else {
+    auto allocator = *static_cast<Allocator **>(block);
+    allocator->deallocate(block, header_size + size);
+  }
+}
+} // namespace simcpp20
@@ -0,0 +1,135 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cstddef>     // std::size_t
+#include <new>         // placement new
+#include <type_traits> // std::decay_t, std::enable_if_t, std::is_same_v
+#include <utility>     // std::forward, std::move
+
+namespace simcpp20::detail {
+/**
+ * Move-only callable wrapper. Callables fitting into the inline storage are
+ * stored without allocating memory. This is guaranteed for the callbacks used
+ * by the library itself. Larger callables are allocated on the heap.
+ *
+ * @tparam Arg Argument type of the callable.
+ */
+template <typename Arg> class callback {
+public:
+  /// Size of the inline storage in bytes.
+  static constexpr std::size_t inline_size = 4 * sizeof(void *);
+
+  /**
+   * Constructor.
+   *
+   * @tparam F Type of the callable.
+   * @param f Callable.
+   */
+  template <typename F,
+            typename = std::enable_if_t<
+                !std::is_same_v<std::decay_t<F>, callback>>>
+  callback(F &&f) { // NOLINT(google-explicit-constructor)
+    using stored = std::decay_t<F>;
+
+    if constexpr (fits_inline<stored>()) {
+      new (storage_) stored(std::forward<F>(f));
+      ops_ = &inline_ops<stored>;
+    } else {
+      *reinterpret_cast<stored **>(storage_) =
+          new stored(std::forward<F>(f));
+      ops_ = &heap_ops<stored>;
+    }
+  }
+
+  /**
+   * Move constructor.
+   *
+   * @param other Callback to move.
+   */
+  callback(callback &&other) noexcept : ops_{other.ops_} {
+    ops_->move(other.storage_, storage_);
+    other.ops_ = &empty_ops;
+  }
+
+  /**
+   * Move assignment operator.
+   *
+   * @param other Callback to replace this callback with.
+   * @return Reference to this instance.
+   */
+  callback &operator=(callback &&other) noexcept {
+    if (this != &other) {
+      ops_->destroy(storage_);
+      ops_ = other.ops_;
+      ops_->move(other.storage_, storage_);
+      other.ops_ = &empty_ops;
+    }
+
+    return *this;
+  }
+
+  callback(const callback &) = delete;
+  callback &operator=(const callback &) = delete;
+
+  /// Destructor.
+  ~callback() { ops_->destroy(storage_); }
+
+  /// @param arg Argument to call the callable with.
+  void operator()(Arg arg) { ops_->invoke(storage_, arg); }
+
+private:
+  /// Operations on the stored callable.
+  struct operations {
+    /// Call the callable.
+    void (*invoke)(void *storage, Arg arg);
+
+    /// Move the callable from one storage to another and destroy the source.
+    void (*move)(void *from, void *to) noexcept;
+
+    /// Destroy the callable.
+    void (*destroy)(void *storage) noexcept;
+  };
+
+  /**
+   * @tparam F Type of the callable.
+   * @return Whether the callable is stored inline.
+   */
+  template <typename F> static constexpr bool fits_inline() {
+    return sizeof(F) <= inline_size &&
+           alignof(F) <= alignof(void *) &&
+           std::is_nothrow_move_constructible_v<F>;
+  }
+
+  /// Operations for a moved-from callback.
+  static constexpr operations empty_ops = {
+      [](void *, Arg) {}, [](void *, void *) noexcept {},
+      [](void *) noexcept {}};
+
+  /// Operations for a callable stored inline.
+  template <typename F>
+  static constexpr operations inline_ops = {
+      [](void *storage, Arg arg) { (*static_cast<F *>(storage))(arg); },
+      [](void *from, void *to) noexcept {
+        new (to) F(std::move(*static_cast<F *>(from)));
+        static_cast<F *>(from)->~F();
+      },
+      [](void *storage) noexcept { static_cast<F *>(storage)->~F(); }};
+
+  /// Operations for a callable allocated on the heap.
+  template <typename F>
+  static constexpr operations heap_ops = {
+      [](void *storage, Arg arg) { (**static_cast<F **>(storage))(arg); },
+      [](void *from, void *to) noexcept {
+        *static_cast<F **>(to) = *static_cast<F **>(from);
+      },
+      [](void *storage) noexcept { delete *static_cast<F **>(storage); }};
+
+  /// Inline storage for the callable or a pointer to it.
+  alignas(void *) unsigned char storage_[inline_size];
+
+  /// Operations on the stored callable.
+  const operations *ops_;
+};
+} // namespace simcpp20::detail
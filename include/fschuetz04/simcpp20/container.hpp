@@ -0,0 +1,161 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <limits>  // std::numeric_limits
+
+#include "monitor.hpp"
+#include "simulation.hpp"
+#include "waiter_list.hpp"
+
+namespace simcpp20 {
+/**
+ * Container holding an amount of a homogeneous matter, for example the fuel
+ * of a gas station. Puts wait while they would exceed the capacity, gets wait
+ * while the level is too low. Both are granted in the order they are made.
+ *
+ * @tparam Amount Type used for amounts of matter.
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulation.
+ */
+template <typename Amount = double, typename Time = double,
+          typename Policy = default_policy>
+class container {
+public:
+  /// Event type.
+  using event_type = event<Time, Policy>;
+
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation.
+   * @param capacity Maximum level.
+   * @param level Initial level.
+   */
+  explicit container(simulation<Time, Policy> &sim,
+                     Amount capacity = std::numeric_limits<Amount>::max(),
+                     Amount level = Amount{0})
+      : sim_{sim}, puts_{[this](auto &) { trigger(); }},
+        gets_{[this](auto &) { trigger(); }}, capacity_{capacity},
+        level_{level} {
+    assert(level_ >= Amount{0} && level_ <= capacity_);
+  }
+
+  container(const container &) = delete;
+  container &operator=(const container &) = delete;
+
+  /**
+   * @param amount Amount to put into the container. Must not exceed the
+   * capacity.
+   * @return Pending event which is triggered once the amount is put into the
+   * container.
+   */
+  event_type put(Amount amount) {
+    assert(amount > Amount{0} && amount <= capacity_);
+
+    auto ev = sim_.event();
+    if (puts_.empty() && amount <= capacity_ - level_) {
+      level_ += amount;
+      ev.trigger();
+      trigger();
+    } else {
+      puts_.push_back(ev, amount);
+    }
+
+    return ev;
+  }
+
+  /**
+   * @param amount Amount to get from the container. Must not exceed the
+   * capacity.
+   * @return Pending event which is triggered once the amount is taken from the
+   * container.
+   */
+  event_type get(Amount amount) {
+    assert(amount > Amount{0} && amount <= capacity_);
+
+    auto ev = sim_.event();
+    if (gets_.empty() && amount <= level_) {
+      level_ -= amount;
+      ev.trigger();
+      trigger();
+    } else {
+      gets_.push_back(ev, amount);
+    }
+
+    return ev;
+  }
+
+  /// @return Current level.
+  Amount level() const { return level_; }
+
+  /// @return Maximum level.
+  Amount capacity() const { return capacity_; }
+
+  /// @return Number of waiting puts.
+  std::size_t queued_puts() const { return puts_.size(); }
+
+  /// @return Number of waiting gets.
+  std::size_t queued_gets() const { return gets_.size(); }
+
+  /**
+   * Record the level in a time-weighted monitor from now on.
+   *
+   * @param level Monitor of the level, or nullptr.
+   */
+  void monitor(time_weighted<Time, Policy> *level) {
+    level_monitor_ = level;
+    trigger();
+  }
+
+private:
+  /**
+   * Grant waiting puts and gets until the first put and the first get must
+   * wait. Also called when a waiting put or get is aborted, since the next one
+   * may be granted then.
+   */
+  void trigger() {
+    bool progress = true;
+    while (progress) {
+      progress = false;
+
+      while (!puts_.empty() && puts_.front_payload() <= capacity_ - level_) {
+        level_ += puts_.front_payload();
+        puts_.pop_front().trigger();
+        progress = true;
+      }
+
+      while (!gets_.empty() && gets_.front_payload() <= level_) {
+        level_ -= gets_.front_payload();
+        gets_.pop_front().trigger();
+        progress = true;
+      }
+    }
+
+    if (level_monitor_ != nullptr) {
+      level_monitor_->set(static_cast<double>(level_));
+    }
+  }
+
+  /// Reference to the simulation.
+  simulation<Time, Policy> &sim_;
+
+  /// Waiting puts with their amounts.
+  detail::waiter_list<event_type, Amount> puts_;
+
+  /// Waiting gets with their amounts.
+  detail::waiter_list<event_type, Amount> gets_;
+
+  /// Maximum level.
+  Amount capacity_;
+
+  /// Current level.
+  Amount level_;
+
+  /// Monitor of the level, or nullptr.
+  time_weighted<Time, Policy> *level_monitor_ = nullptr;
+};
+} // namespace simcpp20
@@ -5,29 +5,44 @@
 
 #include <cassert>    // assert
 #include <cmath>      // std::log2
-#include <coroutine>  // std::coroutine_handle, std::suspend_never
+#include <coroutine>  // std::coroutine_handle, std::noop_coroutine, ...
 #include <cstddef>    // std::size_t
-#include <functional> // std::function
 #include <functional> // std::hash
-#include <utility>    // std::exchange
-#include <vector>     // std::vector
+#include <new>        // std::destroying_delete_t
+#include <utility>    // std::exchange, std::forward
+
+#include "callback.hpp"
+#include "policy.hpp"
+#include "small_vector.hpp"
+#include "waiter_heap.hpp"
+#include "waiter_list.hpp"
 
 namespace simcpp20 {
-template <typename Time> class simulation;
+template <typename Time = double, typename Policy = default_policy>
+class simulation;
+
+template <typename Time = double, typename Policy = default_policy>
+class process;
 
 /**
  * One event.
  *
+ * The shared data of the event is allocated by the allocator of the
+ * simulation, so the event must not outlive the simulation.
+ *
  * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulation.
  */
-template <typename Time = double> class event {
+template <typename Time = double, typename Policy = default_policy>
+class event {
 public:
   /**
    * Constructor.
    *
    * @param simulation Reference to the simulation.
    */
-  explicit event(simulation<Time> &sim) : data_{new data(sim)} {
+  explicit event(simulation<Time, Policy> &sim)
+      : data_{new (sim) data(sim)} {
     data_->use_count_ += 1;
   }
 
@@ -96,6 +111,7 @@ public:
       return;
     }
 
+    data_->sim_.observer().on_trigger(data_->sim_.now());
     data_->sim_.schedule(*this);
     data_->state_ = state::triggered;
   }
@@ -116,17 +132,31 @@ public:
     }
 
     data_->state_ = state::aborted;
+    data_->sim_.observer().on_abort(data_->sim_.now());
 
-    for (auto &handle : data_->handles_) {
-      handle.destroy();
+    if (data_->scheduled_ > 0) {
+      data_->sim_.cancel(data_->scheduled_);
+    }
+
+    for (auto &coroutine : data_->handles_) {
+      coroutine.handle_.destroy();
     }
     data_->handles_.clear();
 
     data_->cbs_.clear();
+    data_->unlink_conditions();
+
+    if (data_->waiter_ != nullptr) {
+      std::exchange(data_->waiter_, nullptr)->cancel();
+    }
   }
 
-  /// @param cb Callback to be called when the event is processed.
-  void add_callback(std::function<void(const event<Time> &)> cb) const {
+  /**
+   * @tparam Callback Type of the callback. Must be callable with a const
+   * reference to the event.
+   * @param cb Callback to be called when the event is processed.
+   */
+  template <typename Callback> void add_callback(Callback &&cb) const {
     assert(awaiting_ev_ == nullptr);
     assert(data_ != nullptr);
 
@@ -134,7 +164,7 @@ public:
       return;
     }
 
-    data_->cbs_.emplace_back(cb);
+    data_->cbs_.emplace_back(std::forward<Callback>(cb));
   }
 
   /// @return Whether the event is pending.
@@ -193,7 +223,7 @@ public:
       return;
     }
 
-    data_->handles_.push_back(handle);
+    data_->handles_.push_back({handle, &handle.promise().ev_});
     decrement_use_count();
     awaiting_ev_ = &handle.promise().ev_;
   }
@@ -201,6 +231,9 @@ public:
   /**
    * Called when a coroutine is resumed after using co_await on the event or if
    * the coroutine did not need to be suspended.
+   *
+   * If the event of the awaiting coroutine is aborted while the coroutine is
+   * suspended, the coroutine is destroyed instead of being resumed.
    */
   void await_resume() {
     assert(data_ != nullptr);
@@ -210,11 +243,7 @@ public:
     }
 
     data_->use_count_ += 1;
-    auto awaiting_ev = std::exchange(awaiting_ev_, nullptr);
-
-    if (awaiting_ev->aborted()) {
-      throw nullptr;
-    }
+    awaiting_ev_ = nullptr;
   }
 
   /**
@@ -224,7 +253,7 @@ public:
    * @return New pending event which is triggered when this event or the other
    * event is processed.
    */
-  event<Time> operator|(const event<Time> &other) const {
+  event<Time, Policy> operator|(const event<Time, Policy> &other) const {
     assert(awaiting_ev_ == nullptr);
     assert(data_ != nullptr);
     return data_->sim_.any_of({*this, other});
@@ -237,7 +266,7 @@ public:
    * @return New pending event which is triggered when this event and the other
    * event are processed.
    */
-  event<Time> operator&(const event<Time> &other) const {
+  event<Time, Policy> operator&(const event<Time, Policy> &other) const {
     assert(awaiting_ev_ == nullptr);
     assert(data_ != nullptr);
     return data_->sim_.all_of({*this, other});
@@ -248,7 +277,7 @@ public:
    * @param other Other event.
    * @return Whether this event is equal to the other event.
    */
-  bool operator==(const event<Time> &other) const {
+  bool operator==(const event<Time, Policy> &other) const {
     return data_ == other.data_;
   }
 
@@ -263,7 +292,7 @@ public:
      * @param sim Reference to the simulation.
      */
     template <typename... Args>
-    explicit promise_type(simulation<Time> &sim, Args &&...)
+    explicit promise_type(simulation<Time, Policy> &sim, Args &&...)
         : sim_{sim}, ev_{sim} {}
 
     /**
@@ -276,7 +305,7 @@ public:
      * @param sim Reference to the simulation.
      */
     template <typename Class, typename... Args>
-    explicit promise_type(Class &&, simulation<Time> &sim, Args &&...)
+    explicit promise_type(Class &&, simulation<Time, Policy> &sim, Args &&...)
         : sim_{sim}, ev_{sim} {}
 
     /**
@@ -292,6 +321,66 @@ public:
     template <typename Class, typename... Args>
     explicit promise_type(Class &&c, Args &&...) : sim_{c.sim}, ev_{c.sim} {}
 
+    /**
+     * Allocate the coroutine frame using the allocator of the simulation.
+     *
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame in bytes.
+     * @param sim Reference to the simulation.
+     * @return Pointer to the coroutine frame.
+     */
+    template <typename... Args>
+    static void *operator new(std::size_t size, simulation<Time, Policy> &sim,
+                              Args &&...) {
+      return allocate_frame(&sim.allocator(), size);
+    }
+
+    /**
+     * Allocate the coroutine frame using the allocator of the simulation.
+     *
+     * @tparam Class Class type if the coroutine function is a lambda or a
+     * member function of a class.
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame in bytes.
+     * @param sim Reference to the simulation.
+     * @return Pointer to the coroutine frame.
+     */
+    template <typename Class, typename... Args>
+    static void *operator new(std::size_t size, Class &&,
+                              simulation<Time, Policy> &sim, Args &&...) {
+      return allocate_frame(&sim.allocator(), size);
+    }
+
+    /**
+     * Allocate the coroutine frame using the allocator of the simulation.
+     *
+     * @tparam Class Class type if the coroutine function is a member function
+     * of a class. Must contain a member variable sim referencing the simulation
+     * instance.
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame in bytes.
+     * @param c Class instance.
+     * @return Pointer to the coroutine frame.
+     */
+    template <typename Class, typename... Args>
+    static void *operator new(std::size_t size, Class &&c, Args &&...) {
+      return allocate_frame(&c.sim.allocator(), size);
+    }
+
+    /**
+     * Deallocate the coroutine frame.
+     *
+     * @param ptr Pointer to the coroutine frame.
+     * @param size Size of the coroutine frame in bytes.
+     */
+    SIMCPP20_FRAME_DELETE static void operator delete(void *ptr,
+                                                      std::size_t size) {
+      deallocate_frame<typename Policy::allocator>(ptr, size);
+    }
+
 #ifdef __INTELLISENSE__
     // IntelliSense fix. See https://stackoverflow.com/q/67209981.
     promise_type();
@@ -303,43 +392,142 @@ public:
      * @return Event associated with the coroutine. This event is triggered
      * when the coroutine returns.
      */
-    event<Time> get_return_object() const { return ev_; }
+    event<Time, Policy> get_return_object() const { return ev_; }
 
     /**
-     * Called when the coroutine is started. The coroutine awaits the return
-     * value before running.
+     * Called when the coroutine is started. Unless the policy requests an
+     * eager start, the coroutine awaits the return value before running.
      *
-     * @return Event which will be processed at the current simulation time.
+     * @return Awaitable which is always ready if the start is eager, otherwise
+     * a delay of 0, so the coroutine runs at the current simulation time after
+     * all events already scheduled for that time.
      */
-    event<Time> initial_suspend() const { return sim_.timeout(Time{0}); }
+    auto initial_suspend() const {
+      if constexpr (Policy::eager_start) {
+        return std::suspend_never{};
+      } else {
+        return sim_.delay(Time{0});
+      }
+    }
 
     /// Called when an exception is thrown inside the coroutine and not handled.
     void unhandled_exception() const { assert(false); }
 
     /**
      * Called when the coroutine returns. Trigger the event associated with the
-     * coroutine.
+     * coroutine. If the policy enables symmetric transfer and exactly one
+     * coroutine awaits the event, that coroutine is resumed directly instead.
      */
-    void return_void() const { ev_.trigger(); }
+    void return_void() {
+      if constexpr (Policy::symmetric_transfer) {
+        next_ = ev_.trigger_or_transfer();
+      } else {
+        ev_.trigger();
+      }
+    }
 
     /**
      * Called after the coroutine returns.
      *
-     * @return Awaitable which is always ready.
+     * @return Awaitable transferring control to the coroutine to resume next
+     * if the policy enables symmetric transfer, otherwise awaitable which is
+     * always ready.
      */
-    std::suspend_never final_suspend() const noexcept { return {}; }
+    auto final_suspend() const noexcept {
+      if constexpr (Policy::symmetric_transfer) {
+        return final_awaitable{next_};
+      } else {
+        return std::suspend_never{};
+      }
+    }
 
     /// Refernece to the simulation.
-    simulation<Time> &sim_;
+    simulation<Time, Policy> &sim_;
 
     /**
      * Event associated with the coroutine. This event is triggered when the
      * coroutine returns.
      */
-    event<Time> ev_;
+    event<Time, Policy> ev_;
+
+    /// Coroutine to resume after this coroutine returns.
+    std::coroutine_handle<> next_ = std::noop_coroutine();
   };
 
 protected:
+  /**
+   * Final awaitable of a process if the policy enables symmetric transfer.
+   * The returned coroutine is suspended at its final suspend point and control
+   * is transferred to the next coroutine directly. The frame of the returned
+   * coroutine is destroyed by the simulation before the next step.
+   */
+  class final_awaitable {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param next Coroutine to resume next.
+     */
+    explicit final_awaitable(std::coroutine_handle<> next) : next_{next} {}
+
+    /// @return Whether the coroutine can continue without being suspended.
+    bool await_ready() const noexcept { return false; }
+
+    /**
+     * @tparam Promise Promise type of the returned coroutine.
+     * @param handle Handle of the returned coroutine.
+     * @return Handle of the coroutine to resume next.
+     */
+    template <typename Promise>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+      auto next = next_;
+      handle.promise().sim_.retire(handle);
+      return next;
+    }
+
+    /// Never called, since the coroutine is not resumed.
+    void await_resume() const noexcept {}
+
+  private:
+    /// Coroutine to resume next.
+    std::coroutine_handle<> next_;
+  };
+
+  /**
+   * Trigger the event. If exactly one coroutine and nothing else awaits the
+   * event, set the event state to processed instead, so the coroutine can be
+   * resumed directly using symmetric transfer.
+   *
+   * @return Handle of the coroutine to resume directly, or a no-op coroutine
+   * handle if the event was triggered.
+   */
+  std::coroutine_handle<> trigger_or_transfer() const {
+    assert(awaiting_ev_ == nullptr);
+    assert(data_ != nullptr);
+
+    if (pending() && data_->handles_.size() == 1 && data_->cbs_.empty() &&
+        data_->conds_.empty()) {
+      auto &observer = data_->sim_.observer();
+      observer.on_trigger(data_->sim_.now());
+      observer.on_process(data_->sim_.now(), 1, 0);
+
+      data_->state_ = state::processed;
+      auto coroutine = data_->handles_[0];
+      data_->handles_.clear();
+
+      if (coroutine.ev_->aborted()) {
+        coroutine.handle_.destroy();
+        return std::noop_coroutine();
+      }
+
+      return coroutine.handle_;
+    }
+
+    trigger();
+    return std::noop_coroutine();
+  }
+
   /**
    * Set the event state to processed, resume all coroutines awaiting this
    * event, and call all callbacks added to the event.
@@ -353,9 +541,11 @@ protected:
     }
 
     data_->state_ = state::processed;
+    data_->sim_.observer().on_process(data_->sim_.now(), data_->handles_.size(),
+                                      data_->cbs_.size());
 
-    for (auto &handle : data_->handles_) {
-      handle.resume();
+    for (auto &coroutine : data_->handles_) {
+      coroutine.resume();
     }
     data_->handles_.clear();
 
@@ -363,6 +553,11 @@ protected:
       cb(*this);
     }
     data_->cbs_.clear();
+
+    for (std::size_t i = 0; i < data_->conds_.size(); ++i) {
+      data_->conds_[i].cond_->child_processed();
+    }
+    data_->unlink_conditions();
   }
 
   /**
@@ -396,6 +591,49 @@ protected:
     aborted
   };
 
+  class data;
+  class condition;
+
+  /// Suspended coroutine, together with the event associated with it.
+  struct suspended_coroutine {
+    /// Handle of the coroutine.
+    std::coroutine_handle<> handle_ = {};
+
+    /// Event associated with the coroutine, stored in its promise.
+    const event *ev_ = nullptr;
+
+    /**
+     * Resume the coroutine. If the event associated with the coroutine is
+     * aborted, destroy the coroutine instead.
+     */
+    void resume() const {
+      if (ev_->aborted()) {
+        handle_.destroy();
+      } else {
+        handle_.resume();
+      }
+    }
+  };
+
+  /// Link from an event to a condition waiting for it.
+  struct condition_link {
+    /// Condition waiting for the event.
+    condition *cond_;
+
+    /// Index of the corresponding child link in the children of the condition.
+    std::size_t child_index_;
+  };
+
+  /// Link from a condition to one of the events it waits for.
+  struct child_link {
+    /// Shared data of the event.
+    data *child_;
+
+    /// Index of the corresponding condition link in the conditions of the
+    /// event.
+    std::size_t cond_index_;
+  };
+
   /// Shared data of the event.
   class data {
   public:
@@ -404,12 +642,61 @@ protected:
      *
      * @param sim Reference to the simulation.
      */
-    explicit data(simulation<Time> &sim) : sim_{sim} {}
+    explicit data(simulation<Time, Policy> &sim) : sim_{sim} {}
+
+    /**
+     * Allocate shared data using the allocator of the simulation.
+     *
+     * @param size Size of the shared data in bytes.
+     * @param sim Reference to the simulation.
+     * @return Pointer to the allocated memory.
+     */
+    static void *operator new(std::size_t size, simulation<Time, Policy> &sim) {
+      return sim.allocator().allocate(size);
+    }
+
+    /**
+     * Destroy the shared data and return its memory to the allocator of the
+     * simulation. Since the destructor is virtual, size is the size of the
+     * dynamic type.
+     *
+     * @param ptr Pointer to the shared data.
+     * @param size Size of the shared data in bytes.
+     */
+    static void operator delete(data *ptr, std::destroying_delete_t,
+                                std::size_t size) {
+      auto &sim = ptr->sim_;
+      ptr->~data();
+      sim.allocator().deallocate(ptr, size);
+    }
 
     /// Destructor.
     virtual ~data() {
-      for (auto &handle : handles_) {
-        handle.destroy();
+      for (auto &coroutine : handles_) {
+        coroutine.handle_.destroy();
+      }
+
+      unlink_conditions();
+    }
+
+    /**
+     * Remove all links to conditions waiting for this event. Each link holds a
+     * reference to the shared data of the condition.
+     */
+    void unlink_conditions() {
+      while (!conds_.empty()) {
+        auto link = conds_.back();
+        link.cond_->remove_child(link.child_index_);
+        conds_.pop_back();
+        link.cond_->release();
+      }
+    }
+
+    /// Decrement the use count and delete the shared data if it reaches 0.
+    void release() {
+      use_count_ -= 1;
+      if (use_count_ == 0) {
+        delete this;
       }
     }
 
@@ -419,14 +706,128 @@ protected:
     /// State of the event.
     state state_ = state::pending;
 
-    /// Handles of coroutines awaiting the event.
-    std::vector<std::coroutine_handle<>> handles_ = {};
+    /// Coroutines awaiting the event. Usually, there is only one.
+    detail::small_vector<suspended_coroutine, 1> handles_ = {};
+
+    /// Callbacks added to the event. Usually, there is at most one.
+    detail::small_vector<detail::callback<const event<Time, Policy> &>, 1>
+        cbs_ = {};
+
+    /// Conditions waiting for the event.
+    detail::small_vector<condition_link, 1> conds_ = {};
 
-    /// Callbacks added to the event.
-    std::vector<std::function<void(const event<Time> &)>> cbs_ = {};
+    /// Entry of the event in a waiter list, for example of a resource.
+    detail::waiter *waiter_ = nullptr;
+
+    /// Number of entries of the event in the event queue of the simulation.
+    std::size_t scheduled_ = 0;
 
     /// Reference to the simulation.
-    simulation<Time> &sim_;
+    simulation<Time, Policy> &sim_;
+  };
+
+  /**
+   * Shared data of an event which is triggered once a number of other events
+   * (its children) are processed. Used by simulation::any_of and
+   * simulation::all_of.
+   *
+   * Children and condition are linked in both directions, with each link
+   * storing the index of its counterpart, so links are removed in constant
+   * time. Once the condition is triggered, it removes its links from all
+   * children which are not processed yet.
+   */
+  class condition : public data {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param sim Reference to the simulation.
+     * @param remaining Number of children which must be processed before the
+     * condition is triggered.
+     */
+    condition(simulation<Time, Policy> &sim, std::size_t remaining)
+        : data{sim}, remaining_{remaining} {}
+
+    /**
+     * Wait for the given event. Does nothing if the event is processed or
+     * aborted.
+     *
+     * @param child Shared data of the event.
+     */
+    void add_child(data *child) {
+      if (child->state_ == state::processed ||
+          child->state_ == state::aborted) {
+        return;
+      }
+
+      children_.push_back({child, child->conds_.size()});
+      child->conds_.push_back({this, children_.size() - 1});
+      data::use_count_ += 1;
+    }
+
+    /**
+     * Called when a child is processed. Trigger the condition if no more
+     * children must be processed.
+     */
+    void child_processed() {
+      if (data::state_ != state::pending || --remaining_ > 0) {
+        return;
+      }
+
+      // keep the condition alive while removing the links to the children
+      event self{this};
+      detach();
+      self.trigger();
+    }
+
+    /**
+     * Remove the link to a child from the children of this condition. The
+     * link in the conditions of the child must be removed by the caller.
+     *
+     * @param i Index of the link in the children of this condition.
+     */
+    void remove_child(std::size_t i) {
+      auto &last = children_.back();
+      if (i != children_.size() - 1) {
+        children_[i] = last;
+        last.child_->conds_[last.cond_index_].child_index_ = i;
+      }
+
+      children_.pop_back();
+    }
+
+  private:
+    /// Remove the links to all children which are not processed yet.
+    void detach() {
+      for (std::size_t i = children_.size(); i-- > 0;) {
+        auto link = children_[i];
+
+        // a processed child removes its links itself after notifying all
+        // conditions
+        if (link.child_->state_ == state::processed) {
+          continue;
+        }
+
+        auto &conds = link.child_->conds_;
+        auto &last = conds.back();
+        if (link.cond_index_ != conds.size() - 1) {
+          conds[link.cond_index_] = last;
+          last.cond_->children_[last.child_index_].cond_index_ =
+              link.cond_index_;
+        }
+
+        conds.pop_back();
+        remove_child(i);
+        data::release();
+      }
+    }
+
+    /// Number of children which must be processed before the condition is
+    /// triggered.
+    std::size_t remaining_;
+
+    /// Children of the condition which are not processed yet.
+    detail::small_vector<child_link, 2> children_ = {};
   };
 
   /**
@@ -445,21 +846,25 @@ protected:
   /// Shared data of the event.
   data *data_;
 
-  friend class simulation<Time>;
-  friend struct std::hash<event<Time>>;
+  friend class simulation<Time, Policy>;
+  friend class process<Time, Policy>;
+  template <typename, typename> friend class detail::waiter_list;
+  template <typename, typename> friend class detail::waiter_heap;
+  friend struct std::hash<event<Time, Policy>>;
 };
 } // namespace simcpp20
 
 namespace std {
 /// Spezialization of std::hash for simcpp20::event.
-template <typename Time> struct hash<simcpp20::event<Time>> {
+template <typename Time, typename Policy>
+struct hash<simcpp20::event<Time, Policy>> {
   /**
    * @param ev Event.
    * @return Hash of the event.
    */
-  std::size_t operator()(const simcpp20::event<Time> &ev) const {
+  std::size_t operator()(const simcpp20::event<Time, Policy> &ev) const {
     static const std::size_t shift =
-        std::log2(1 + sizeof(simcpp20::event<Time>));
+        std::log2(1 + sizeof(simcpp20::event<Time, Policy>));
     return reinterpret_cast<std::size_t>(ev.data_) >> shift;
   }
 };
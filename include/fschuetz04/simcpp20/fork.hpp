@@ -0,0 +1,215 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm>    // std::max
+#include <cerrno>       // errno, EINTR
+#include <cstddef>      // std::size_t
+#include <cstdio>       // std::fflush
+#include <functional>   // std::invoke
+#include <stdexcept>    // std::runtime_error
+#include <system_error> // std::system_error, std::generic_category
+#include <thread>       // std::thread
+#include <type_traits>  // std::invoke_result_t, std::is_trivially_copyable_v
+#include <vector>       // std::vector
+
+#include <sys/types.h> // pid_t
+#include <sys/wait.h>  // waitpid, WIFEXITED, WEXITSTATUS
+#include <unistd.h>    // fork, pipe, read, write, close, _exit
+
+namespace simcpp20 {
+namespace detail {
+/// Child process running a variant.
+struct forked_variant {
+  /// Process ID of the child.
+  pid_t pid_;
+
+  /// Read end of the pipe receiving the result.
+  int fd_;
+};
+
+/**
+ * Read from a file descriptor until the buffer is full or the end of the file
+ * is reached.
+ *
+ * @param fd File descriptor.
+ * @param data Buffer.
+ * @param size Size of the buffer in bytes.
+ * @return Number of bytes read.
+ */
+inline std::size_t read_all(int fd, char *data, std::size_t size) {
+  std::size_t n = 0;
+  while (n < size) {
+    auto r = ::read(fd, data + n, size - n);
+    if (r == 0 || (r < 0 && errno != EINTR)) {
+      break;
+    }
+
+    if (r > 0) {
+      n += static_cast<std::size_t>(r);
+    }
+  }
+
+  return n;
+}
+
+/**
+ * Write a whole buffer to a file descriptor.
+ *
+ * @param fd File descriptor.
+ * @param data Buffer.
+ * @param size Size of the buffer in bytes.
+ * @return Whether the whole buffer was written.
+ */
+inline bool write_all(int fd, const char *data, std::size_t size) {
+  std::size_t n = 0;
+  while (n < size) {
+    auto r = ::write(fd, data + n, size - n);
+    if (r < 0 && errno != EINTR) {
+      return false;
+    }
+
+    if (r > 0) {
+      n += static_cast<std::size_t>(r);
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Wait for a forked variant to exit.
+ *
+ * @param variant Forked variant.
+ * @return Whether the child exited with status 0.
+ */
+inline bool wait_for(forked_variant variant) {
+  ::close(variant.fd_);
+
+  int status = 0;
+  while (::waitpid(variant.pid_, &status, 0) < 0) {
+    if (errno != EINTR) {
+      return false;
+    }
+  }
+
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+} // namespace detail
+
+/**
+ * Run variants of a model starting from the current state of the process,
+ * each in a forked child process.
+ *
+ * The state of a simulation consists of coroutine frames, events and
+ * callbacks referencing each other and the model, which cannot be serialized
+ * in general. Forking copies the whole process lazily instead: the operating
+ * system shares all pages between the parent and the children and only copies
+ * a page once it is written. Thus, a model can be warmed up once and each
+ * variant continues from the warmed-up state, without repeating the warm-up
+ * and without affecting the state of the parent or other variants:
+ *
+ *     sim.run_until(warm_up);
+ *     auto results = simcpp20::fork_variants(100, [&](std::size_t i) {
+ *       // change the model according to variant i
+ *       sim.run_until(warm_up + period);
+ *       return result;  // trivially copyable
+ *     });
+ *
+ * Each child calls the variant, sends its result to the parent through a pipe
+ * and exits without running destructors or handlers registered with atexit.
+ *
+ * Must only be called while the process has a single thread, since only the
+ * calling thread exists in the children. Only available on POSIX systems.
+ *
+ * @tparam F Type of the variant. Must be callable with the index of the
+ * variant and return a trivially copyable, default constructible type.
+ * @param n Number of variants.
+ * @param variant Variant, called once in each child.
+ * @param n_parallel Maximum number of children running at the same time. If
+ * 0, the number of hardware threads is used.
+ * @return Results of the variants, ordered by index.
+ * @throw std::system_error If creating a pipe or child fails.
+ * @throw std::runtime_error If a variant throws an exception or a child does
+ * not send its result. All started children are waited for before throwing.
+ */
+template <typename F>
+auto fork_variants(std::size_t n, F &&variant, std::size_t n_parallel = 0) {
+  using result_type = std::invoke_result_t<F &, std::size_t>;
+  static_assert(std::is_trivially_copyable_v<result_type>,
+                "results are copied byte by byte from the children");
+
+  if (n_parallel == 0) {
+    n_parallel = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  std::vector<result_type> results(n);
+  std::vector<detail::forked_variant> children;
+  children.reserve(n);
+
+  // buffered output would otherwise be written by each child again
+  std::fflush(nullptr);
+
+  auto start = [&](std::size_t i) {
+    int fds[2];
+    if (::pipe(fds) != 0) {
+      return errno;
+    }
+
+    pid_t pid = ::fork();
+    if (pid < 0) {
+      int error = errno;
+      ::close(fds[0]);
+      ::close(fds[1]);
+      return error;
+    }
+
+    if (pid == 0) {
+      ::close(fds[0]);
+      try {
+        result_type result = std::invoke(variant, i);
+        bool ok = detail::write_all(fds[1], reinterpret_cast<char *>(&result),
+                                    sizeof(result));
+        ::_exit(ok ? 0 : 1);
+      } catch (...) {
+        ::_exit(1);
+      }
+    }
+
+    ::close(fds[1]);
+    children.push_back({pid, fds[0]});
+    return 0;
+  };
+
+  // children are collected in the order they are started, so a child never
+  // blocks on a full pipe while the parent waits for another child
+  int error = 0;
+  bool failed = false;
+  for (std::size_t i = 0;; ++i) {
+    while (error == 0 && !failed && children.size() < n &&
+           children.size() - i < n_parallel) {
+      error = start(children.size());
+    }
+
+    if (i == children.size()) {
+      break;
+    }
+
+    auto data = reinterpret_cast<char *>(&results[i]);
+    auto n_read = detail::read_all(children[i].fd_, data, sizeof(result_type));
+    bool ok = detail::wait_for(children[i]);
+    failed = failed || !ok || n_read != sizeof(result_type);
+  }
+
+  if (error != 0) {
+    throw std::system_error{error, std::generic_category(), "fork_variants"};
+  }
+
+  if (failed) {
+    throw std::runtime_error{"fork_variants: a variant failed"};
+  }
+
+  return results;
+}
+} // namespace simcpp20
@@ -0,0 +1,28 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cstdint> // std::uint64_t
+
+#include "event.hpp"
+#include "process.hpp"
+#include "simulation.hpp"
+
+/*
+ * If SIMCPP20_EXTERN_TEMPLATES is defined, simulation, event and process are
+ * not instantiated for the common time types double and std::uint64_t in
+ * every translation unit. Instead, the explicit instantiations are taken from
+ * the fschuetz04::simcpp20_instantiations library, which defines the macro
+ * for all targets linking it.
+ */
+#ifdef SIMCPP20_EXTERN_TEMPLATES
+namespace simcpp20 {
+extern template class event<double>;
+extern template class event<std::uint64_t>;
+extern template class process<double>;
+extern template class process<std::uint64_t>;
+extern template class simulation<double>;
+extern template class simulation<std::uint64_t>;
+} // namespace simcpp20
+#endif
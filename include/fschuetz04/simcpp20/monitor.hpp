@@ -0,0 +1,482 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm> // std::fill, std::min, std::max, std::sort
+#include <array>     // std::array
+#include <cassert>   // assert
+#include <cmath>     // std::abs, std::floor, std::log, std::sqrt, std::tan
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint64_t
+#include <limits>    // std::numeric_limits
+#include <vector>    // std::vector
+
+#include "policy.hpp"
+#include "simulation.hpp"
+
+namespace simcpp20 {
+namespace detail {
+/**
+ * Quantile of the Student t distribution, exact for one and two degrees of
+ * freedom and approximated using the Cornish-Fisher expansion around an
+ * approximate normal quantile otherwise, which is accurate to about 0.01 for
+ * three degrees of freedom and better for more.
+ *
+ * @param p Probability. Must be in (0.5, 1).
+ * @param dof Degrees of freedom. Must be positive.
+ * @return Quantile.
+ */
+inline double student_t_quantile(double p, std::uint64_t dof) {
+  assert(p > 0.5 && p < 1);
+  assert(dof > 0);
+
+  constexpr double pi = 3.141592653589793;
+  if (dof == 1) {
+    return std::tan(pi * (p - 0.5));
+  }
+
+  if (dof == 2) {
+    return (2 * p - 1) / std::sqrt(2 * p * (1 - p));
+  }
+
+  // normal quantile (M. Abramowitz and I. Stegun, 26.2.23)
+  double t = std::sqrt(-2 * std::log(1 - p));
+  double z = t - (2.515517 + 0.802853 * t + 0.010328 * t * t) /
+                     (1 + 1.432788 * t + 0.189269 * t * t +
+                      0.001308 * t * t * t);
+
+  double v = static_cast<double>(dof);
+  double z2 = z * z;
+  double g1 = (z2 + 1) * z / 4;
+  double g2 = ((5 * z2 + 16) * z2 + 3) * z / 96;
+  double g3 = (((3 * z2 + 19) * z2 + 17) * z2 - 15) * z / 384;
+  double g4 = ((((79 * z2 + 776) * z2 + 1482) * z2 - 1920) * z2 - 945) * z /
+              92160;
+  return z + g1 / v + g2 / (v * v) + g3 / (v * v * v) + g4 / (v * v * v * v);
+}
+} // namespace detail
+
+/**
+ * Statistics of a series of observations, for example waiting times. The
+ * mean and variance are updated incrementally using Welford's algorithm.
+ */
+class tally {
+public:
+  /// @param x Observation.
+  void add(double x) {
+    ++n_;
+    double delta = x - mean_;
+    mean_ += delta / static_cast<double>(n_);
+    m2_ += delta * (x - mean_);
+    min_ = std::min(min_, x);
+    max_ = std::max(max_, x);
+  }
+
+  /// Remove all observations, for example after a warm-up period.
+  void reset() { *this = tally{}; }
+
+  /// @return Number of observations.
+  std::uint64_t count() const { return n_; }
+
+  /// @return Mean of the observations, or 0 if there are none.
+  double mean() const { return mean_; }
+
+  /// @return Sample variance of the observations, or 0 for less than two.
+  double variance() const {
+    return n_ > 1 ? m2_ / static_cast<double>(n_ - 1) : 0;
+  }
+
+  /// @return Sample standard deviation of the observations.
+  double stddev() const { return std::sqrt(variance()); }
+
+  /**
+   * Half-width of the confidence interval of the mean, assuming independent
+   * and normally distributed observations, for example batch means or the
+   * results of replications.
+   *
+   * @param confidence Confidence level, for example 0.95.
+   * @return Half-width, or infinity for less than two observations.
+   */
+  double half_width(double confidence = 0.95) const {
+    if (n_ < 2) {
+      return std::numeric_limits<double>::infinity();
+    }
+
+    double t = detail::student_t_quantile((1 + confidence) / 2, n_ - 1);
+    return t * stddev() / std::sqrt(static_cast<double>(n_));
+  }
+
+  /**
+   * @param confidence Confidence level, for example 0.95.
+   * @return Half-width of the confidence interval of the mean relative to the
+   * absolute mean. Infinity if the mean is 0 and the half-width is not.
+   */
+  double relative_half_width(double confidence = 0.95) const {
+    double h = half_width(confidence);
+    if (h == 0) {
+      return 0;
+    }
+
+    return h / std::abs(mean_);
+  }
+
+  /// @return Smallest observation, or infinity if there are none.
+  double min() const { return min_; }
+
+  /// @return Largest observation, or -infinity if there are none.
+  double max() const { return max_; }
+
+private:
+  /// Number of observations.
+  std::uint64_t n_ = 0;
+
+  /// Mean of the observations.
+  double mean_ = 0;
+
+  /// Sum of squared differences from the mean.
+  double m2_ = 0;
+
+  /// Smallest observation.
+  double min_ = std::numeric_limits<double>::infinity();
+
+  /// Largest observation.
+  double max_ = -std::numeric_limits<double>::infinity();
+};
+
+/**
+ * Time-weighted statistics of a value changing over simulation time, for
+ * example a queue length or the number of busy servers. Each value is
+ * weighted by the simulation time it is held.
+ *
+ *     simcpp20::time_weighted<> queue_length{sim};
+ *     queue_length.add(1);  // a customer arrives
+ *     queue_length.add(-1); // a customer leaves
+ *     double average = queue_length.mean();
+ *
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulation.
+ */
+template <typename Time = double, typename Policy = default_policy>
+class time_weighted {
+public:
+  /**
+   * Constructor. The observation period starts at the current simulation
+   * time.
+   *
+   * @param sim Reference to the simulation.
+   * @param value Initial value.
+   */
+  explicit time_weighted(simulation<Time, Policy> &sim, double value = 0)
+      : sim_{sim}, start_{sim.now()}, last_{sim.now()}, value_{value},
+        min_{value}, max_{value} {}
+
+  /// @param value New value, held from the current simulation time on.
+  void set(double value) {
+    accumulate();
+    value_ = value;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+
+  /// @param delta Difference to add to the value.
+  void add(double delta) { set(value_ + delta); }
+
+  /**
+   * Start a new observation period at the current simulation time, for
+   * example after a warm-up period. The current value is kept.
+   */
+  void reset() {
+    start_ = last_ = sim_.now();
+    area_ = area2_ = 0;
+    min_ = max_ = value_;
+  }
+
+  /// @return Current value.
+  double value() const { return value_; }
+
+  /// @return Length of the observation period up to the current time.
+  Time duration() const { return sim_.now() - start_; }
+
+  /**
+   * @return Time-weighted mean up to the current simulation time. If the
+   * observation period is empty, the current value.
+   */
+  double mean() const {
+    auto d = static_cast<double>(duration());
+    return d > 0 ? (area_ + value_ * held()) / d : value_;
+  }
+
+  /// @return Time-weighted variance up to the current simulation time.
+  double variance() const {
+    auto d = static_cast<double>(duration());
+    if (d <= 0) {
+      return 0;
+    }
+
+    double m = mean();
+    return std::max((area2_ + value_ * value_ * held()) / d - m * m, 0.0);
+  }
+
+  /// @return Smallest value in the observation period.
+  double min() const { return min_; }
+
+  /// @return Largest value in the observation period.
+  double max() const { return max_; }
+
+private:
+  /// @return Simulation time the current value is held so far.
+  double held() const { return static_cast<double>(sim_.now() - last_); }
+
+  /// Add the area of the current value up to the current simulation time.
+  void accumulate() {
+    double d = held();
+    area_ += value_ * d;
+    area2_ += value_ * value_ * d;
+    last_ = sim_.now();
+  }
+
+  /// Reference to the simulation.
+  simulation<Time, Policy> &sim_;
+
+  /// Start of the observation period.
+  Time start_;
+
+  /// Simulation time at which the current value was set.
+  Time last_;
+
+  /// Current value.
+  double value_;
+
+  /// Integral of the value over time, up to last_.
+  double area_ = 0;
+
+  /// Integral of the squared value over time, up to last_.
+  double area2_ = 0;
+
+  /// Smallest value.
+  double min_;
+
+  /// Largest value.
+  double max_;
+};
+
+/**
+ * Histogram with bins of equal width. Observations outside of the range are
+ * counted separately.
+ */
+class histogram {
+public:
+  /**
+   * Constructor.
+   *
+   * @param lower Lower bound of the first bin.
+   * @param upper Upper bound of the last bin. Must be greater than lower.
+   * @param n_bins Number of bins. Must be positive.
+   */
+  histogram(double lower, double upper, std::size_t n_bins)
+      : lower_{lower}, width_{(upper - lower) / static_cast<double>(n_bins)},
+        bins_(n_bins) {
+    assert(upper > lower);
+    assert(n_bins > 0);
+  }
+
+  /**
+   * @param x Observation.
+   * @param weight Weight of the observation, for example the time a value is
+   * held.
+   */
+  void add(double x, double weight = 1) {
+    total_ += weight;
+
+    double i = std::floor((x - lower_) / width_);
+    if (i < 0) {
+      underflow_ += weight;
+    } else if (i >= static_cast<double>(bins_.size())) {
+      overflow_ += weight;
+    } else {
+      bins_[static_cast<std::size_t>(i)] += weight;
+    }
+  }
+
+  /// Remove all observations.
+  void reset() {
+    std::fill(bins_.begin(), bins_.end(), 0.0);
+    underflow_ = overflow_ = total_ = 0;
+  }
+
+  /// @return Number of bins.
+  std::size_t size() const { return bins_.size(); }
+
+  /**
+   * @param i Index of the bin.
+   * @return Total weight of the observations in the bin.
+   */
+  double operator[](std::size_t i) const {
+    assert(i < size());
+    return bins_[i];
+  }
+
+  /**
+   * @param i Index of the bin.
+   * @return Lower bound of the bin.
+   */
+  double lower_bound(std::size_t i) const {
+    return lower_ + width_ * static_cast<double>(i);
+  }
+
+  /// @return Total weight of the observations below the first bin.
+  double underflow() const { return underflow_; }
+
+  /// @return Total weight of the observations above the last bin.
+  double overflow() const { return overflow_; }
+
+  /// @return Total weight of all observations.
+  double total() const { return total_; }
+
+private:
+  /// Lower bound of the first bin.
+  double lower_;
+
+  /// Width of each bin.
+  double width_;
+
+  /// Total weight per bin.
+  std::vector<double> bins_;
+
+  /// Total weight below the first bin.
+  double underflow_ = 0;
+
+  /// Total weight above the last bin.
+  double overflow_ = 0;
+
+  /// Total weight.
+  double total_ = 0;
+};
+
+/**
+ * Streaming estimate of a quantile using the P² algorithm (R. Jain and
+ * I. Chlamtac, 1985). Only five markers are stored, which are adjusted in
+ * constant time per observation using piecewise-parabolic interpolation.
+ */
+class p2_quantile {
+public:
+  /// @param p Probability of the quantile, for example 0.95.
+  explicit p2_quantile(double p)
+      : increments_{0, p / 2, p, (1 + p) / 2, 1},
+        desired_{1, 1 + 2 * p, 1 + 4 * p, 3 + 2 * p, 5} {
+    assert(p > 0 && p < 1);
+  }
+
+  /// @param x Observation.
+  void add(double x) {
+    if (n_ < 5) {
+      heights_[n_++] = x;
+      if (n_ == 5) {
+        std::sort(heights_.begin(), heights_.end());
+      }
+      return;
+    }
+
+    ++n_;
+
+    // find the cell of the observation and adjust the extreme markers
+    std::size_t k;
+    if (x < heights_[0]) {
+      heights_[0] = x;
+      k = 0;
+    } else if (x >= heights_[4]) {
+      heights_[4] = std::max(heights_[4], x);
+      k = 3;
+    } else {
+      k = 0;
+      while (x >= heights_[k + 1]) {
+        ++k;
+      }
+    }
+
+    for (std::size_t i = k + 1; i < 5; ++i) {
+      positions_[i] += 1;
+    }
+
+    for (std::size_t i = 0; i < 5; ++i) {
+      desired_[i] += increments_[i];
+    }
+
+    for (std::size_t i = 1; i < 4; ++i) {
+      adjust(i);
+    }
+  }
+
+  /// @return Number of observations.
+  std::uint64_t count() const { return n_; }
+
+  /// @return Estimated quantile, or 0 if there are no observations.
+  double value() const {
+    if (n_ >= 5) {
+      return heights_[2];
+    }
+
+    if (n_ == 0) {
+      return 0;
+    }
+
+    // exact quantile of the few observations
+    auto sorted = heights_;
+    std::sort(sorted.begin(), sorted.begin() + n_);
+    auto i = static_cast<std::size_t>(increments_[2] *
+                                      static_cast<double>(n_ - 1));
+    return sorted[i];
+  }
+
+private:
+  /**
+   * Move a middle marker towards its desired position, if it is off by at
+   * least one and the neighboring marker is not adjacent.
+   *
+   * @param i Index of the marker.
+   */
+  void adjust(std::size_t i) {
+    double d = desired_[i] - positions_[i];
+    if (!((d >= 1 && positions_[i + 1] - positions_[i] > 1) ||
+          (d <= -1 && positions_[i - 1] - positions_[i] < -1))) {
+      return;
+    }
+
+    double s = d > 0 ? 1 : -1;
+    auto &q = heights_;
+    auto &n = positions_;
+
+    double parabolic =
+        q[i] + s / (n[i + 1] - n[i - 1]) *
+                   ((n[i] - n[i - 1] + s) * (q[i + 1] - q[i]) /
+                        (n[i + 1] - n[i]) +
+                    (n[i + 1] - n[i] - s) * (q[i] - q[i - 1]) /
+                        (n[i] - n[i - 1]));
+
+    if (q[i - 1] < parabolic && parabolic < q[i + 1]) {
+      q[i] = parabolic;
+    } else {
+      std::size_t j = s > 0 ? i + 1 : i - 1;
+      q[i] += s * (q[j] - q[i]) / (n[j] - n[i]);
+    }
+
+    n[i] += s;
+  }
+
+  /// Number of observations.
+  std::uint64_t n_ = 0;
+
+  /// Heights of the markers.
+  std::array<double, 5> heights_{};
+
+  /// Positions of the markers.
+  std::array<double, 5> positions_{1, 2, 3, 4, 5};
+
+  /// Increments of the desired positions per observation.
+  std::array<double, 5> increments_;
+
+  /// Desired positions of the markers.
+  std::array<double, 5> desired_;
+};
+} // namespace simcpp20
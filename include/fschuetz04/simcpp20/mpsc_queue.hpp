@@ -0,0 +1,98 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <atomic>  // std::atomic, std::memory_order_*
+#include <utility> // std::exchange, std::move
+
+namespace simcpp20::detail {
+/**
+ * Lock-free first-in first-out queue with multiple producers and a single
+ * consumer.
+ *
+ * Producers push onto an intrusive stack using compare-and-swap. The consumer
+ * takes the whole stack with a single exchange and reverses it, so elements
+ * pushed by the same thread are consumed in the order they are pushed.
+ * Checking whether the queue is empty is a single atomic load.
+ *
+ * @tparam T Element type. Must be move constructible.
+ */
+template <typename T> class mpsc_queue {
+public:
+  /// Constructor.
+  mpsc_queue() = default;
+
+  mpsc_queue(const mpsc_queue &) = delete;
+  mpsc_queue &operator=(const mpsc_queue &) = delete;
+
+  /// Destructor. Destroy all elements which are not consumed.
+  ~mpsc_queue() {
+    auto head = head_.load(std::memory_order_acquire);
+    while (head != nullptr) {
+      delete std::exchange(head, head->next_);
+    }
+  }
+
+  /**
+   * Add an element. May be called by any thread.
+   *
+   * @param element Element to add.
+   */
+  void push(T element) {
+    auto n = new node{std::move(element), nullptr};
+    n->next_ = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(n->next_, n, std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * @return Whether the queue is empty. Elements pushed concurrently may not
+   * be visible yet.
+   */
+  bool empty() const {
+    return head_.load(std::memory_order_relaxed) == nullptr;
+  }
+
+  /**
+   * Remove all elements and call a function for each of them, in the order
+   * they are pushed. Must only be called by the consumer. Elements pushed
+   * while consuming are left for the next call.
+   *
+   * @tparam F Type of the function.
+   * @param f Function called with an rvalue reference to each element.
+   */
+  template <typename F> void consume(F &&f) {
+    auto head = head_.exchange(nullptr, std::memory_order_acquire);
+
+    // reverse the stack to restore the push order
+    node *first = nullptr;
+    while (head != nullptr) {
+      auto next = head->next_;
+      head->next_ = first;
+      first = head;
+      head = next;
+    }
+
+    while (first != nullptr) {
+      auto n = std::exchange(first, first->next_);
+      f(std::move(n->element_));
+      delete n;
+    }
+  }
+
+private:
+  /// Node of the stack.
+  struct node {
+    /// Element.
+    T element_;
+
+    /// Next node, pushed before this node.
+    node *next_;
+  };
+
+  /// Last pushed node, or nullptr if the queue is empty.
+  std::atomic<node *> head_{nullptr};
+};
+} // namespace simcpp20::detail
@@ -0,0 +1,321 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm> // std::min
+#include <array>     // std::array
+#include <bit>       // std::bit_width
+#include <cstddef>   // std::size_t
+#include <cstdint>   // std::uint32_t, std::uint64_t
+#include <limits>    // std::numeric_limits
+#include <vector>    // std::vector
+
+namespace simcpp20 {
+/**
+ * Observer doing nothing. Used by default, so all hooks compile away.
+ *
+ * An observer is selected by the policy of a simulation and receives a call
+ * for each of the following hooks. It is default constructed by the
+ * simulation and accessible using simulation::observer.
+ */
+struct null_observer {
+  /**
+   * Called when an event or coroutine is scheduled.
+   *
+   * @tparam Time Type used for simulation time.
+   * @param now Current simulation time.
+   * @param time Time at which the event is processed.
+   * @param id ID of the scheduled entry.
+   */
+  template <typename Time>
+  void on_schedule(Time /* now */, Time /* time */, std::uint64_t /* id */) {}
+
+  /**
+   * Called when a scheduled event or coroutine is taken from the event queue,
+   * before it is processed.
+   *
+   * @tparam Time Type used for simulation time.
+   * @param now Current simulation time.
+   * @param id ID of the scheduled entry.
+   * @param queue_size Number of entries remaining in the event queue.
+   */
+  template <typename Time>
+  void on_step(Time /* now */, std::uint64_t /* id */,
+               std::size_t /* queue_size */) {}
+
+  /**
+   * Called when an event is processed.
+   *
+   * @tparam Time Type used for simulation time.
+   * @param now Current simulation time.
+   * @param n_coroutines Number of resumed coroutines.
+   * @param n_callbacks Number of called callbacks.
+   */
+  template <typename Time>
+  void on_process(Time /* now */, std::size_t /* n_coroutines */,
+                  std::size_t /* n_callbacks */) {}
+
+  /**
+   * Called when a coroutine scheduled without an event is resumed, for example
+   * after sim.delay() or at the start of a process.
+   *
+   * @tparam Time Type used for simulation time.
+   * @param now Current simulation time.
+   */
+  template <typename Time> void on_resume(Time /* now */) {}
+
+  /**
+   * Called when an event is triggered.
+   *
+   * @tparam Time Type used for simulation time.
+   * @param now Current simulation time.
+   */
+  template <typename Time> void on_trigger(Time /* now */) {}
+
+  /**
+   * Called when a pending event is aborted.
+   *
+   * @tparam Time Type used for simulation time.
+   * @param now Current simulation time.
+   */
+  template <typename Time> void on_abort(Time /* now */) {}
+};
+
+/// Observer counting the calls of all hooks.
+struct counting_observer {
+  /// See null_observer::on_schedule.
+  template <typename Time> void on_schedule(Time, Time, std::uint64_t) {
+    ++scheduled_;
+  }
+
+  /// See null_observer::on_step.
+  template <typename Time>
+  void on_step(Time, std::uint64_t, std::size_t queue_size) {
+    ++steps_;
+    max_queue_size_ = std::max(max_queue_size_, queue_size);
+    queue_sizes_[std::min<std::size_t>(std::bit_width(queue_size),
+                                       queue_sizes_.size() - 1)] += 1;
+  }
+
+  /// See null_observer::on_process.
+  template <typename Time>
+  void on_process(Time, std::size_t n_coroutines, std::size_t n_callbacks) {
+    ++processed_;
+    resumed_ += n_coroutines;
+    callbacks_ += n_callbacks;
+  }
+
+  /// See null_observer::on_resume.
+  template <typename Time> void on_resume(Time) { ++resumed_; }
+
+  /// See null_observer::on_trigger.
+  template <typename Time> void on_trigger(Time) { ++triggered_; }
+
+  /// See null_observer::on_abort.
+  template <typename Time> void on_abort(Time) { ++aborted_; }
+
+  /// Number of scheduled events and coroutines.
+  std::uint64_t scheduled_ = 0;
+
+  /// Number of steps.
+  std::uint64_t steps_ = 0;
+
+  /// Number of processed events.
+  std::uint64_t processed_ = 0;
+
+  /// Number of triggered events.
+  std::uint64_t triggered_ = 0;
+
+  /// Number of aborted events.
+  std::uint64_t aborted_ = 0;
+
+  /**
+   * Number of resumed coroutines, whether resumed by processed events or
+   * scheduled without an event.
+   */
+  std::uint64_t resumed_ = 0;
+
+  /// Number of callbacks called by processed events.
+  std::uint64_t callbacks_ = 0;
+
+  /// Maximum size of the event queue after taking an entry.
+  std::size_t max_queue_size_ = 0;
+
+  /**
+   * Histogram of the size of the event queue after taking an entry. Bucket 0
+   * counts empty queues, bucket i counts sizes in [2^(i-1), 2^i).
+   */
+  std::array<std::uint64_t, 32> queue_sizes_{};
+};
+
+/// Kind of a trace record.
+enum class trace_kind : std::uint32_t {
+  /// An event or coroutine is scheduled. The time is the scheduled time.
+  schedule,
+
+  /// An entry is taken from the event queue. The value is the queue size.
+  step,
+
+  /**
+   * An event is processed. The value is the number of resumed coroutines and
+   * called callbacks.
+   */
+  process,
+
+  /// An event is triggered.
+  trigger,
+
+  /// An event is aborted.
+  abort,
+
+  /// Written by trace_observer::mark. The value is the tag.
+  user,
+
+  /// A coroutine scheduled without an event is resumed.
+  resume,
+};
+
+/**
+ * Fixed-size binary trace record. The ID is the ID of the scheduled entry,
+ * which is the entry being processed for all records but schedule.
+ */
+struct trace_record {
+  /// Simulation time.
+  double time_;
+
+  /// ID of the scheduled entry.
+  std::uint64_t id_;
+
+  /// Kind of the record.
+  trace_kind kind_;
+
+  /// Additional value depending on the kind, saturated at its maximum.
+  std::uint32_t value_;
+};
+
+static_assert(sizeof(trace_record) == 24);
+
+/**
+ * Observer creating a trace record for each hook and writing it to a sink.
+ *
+ * @tparam Sink Type of the sink. Must be default constructible and provide
+ * write(const trace_record &).
+ */
+template <typename Sink> class trace_observer {
+public:
+  /// @return Reference to the sink.
+  Sink &sink() { return sink_; }
+
+  /// See null_observer::on_schedule.
+  template <typename Time>
+  void on_schedule(Time, Time time, std::uint64_t id) {
+    write(time, id, trace_kind::schedule, 0);
+  }
+
+  /// See null_observer::on_step.
+  template <typename Time>
+  void on_step(Time now, std::uint64_t id, std::size_t queue_size) {
+    current_id_ = id;
+    write(now, id, trace_kind::step, queue_size);
+  }
+
+  /// See null_observer::on_process.
+  template <typename Time>
+  void on_process(Time now, std::size_t n_coroutines, std::size_t n_callbacks) {
+    write(now, current_id_, trace_kind::process, n_coroutines + n_callbacks);
+  }
+
+  /// See null_observer::on_resume.
+  template <typename Time> void on_resume(Time now) {
+    write(now, current_id_, trace_kind::resume, 0);
+  }
+
+  /// See null_observer::on_trigger.
+  template <typename Time> void on_trigger(Time now) {
+    write(now, current_id_, trace_kind::trigger, 0);
+  }
+
+  /// See null_observer::on_abort.
+  template <typename Time> void on_abort(Time now) {
+    write(now, current_id_, trace_kind::abort, 0);
+  }
+
+  /**
+   * Write a record of the model, for example to tag what a process does.
+   *
+   * @tparam Time Type used for simulation time.
+   * @param now Current simulation time.
+   * @param tag Tag chosen by the model.
+   */
+  template <typename Time> void mark(Time now, std::uint32_t tag) {
+    write(now, current_id_, trace_kind::user, tag);
+  }
+
+private:
+  /**
+   * @tparam Time Type used for simulation time.
+   * @param time Simulation time.
+   * @param id ID of the scheduled entry.
+   * @param kind Kind of the record.
+   * @param value Additional value.
+   */
+  template <typename Time>
+  void write(Time time, std::uint64_t id, trace_kind kind, std::size_t value) {
+    constexpr std::size_t max = std::numeric_limits<std::uint32_t>::max();
+    sink_.write(trace_record{static_cast<double>(time), id, kind,
+                             static_cast<std::uint32_t>(std::min(value, max))});
+  }
+
+  /// Sink receiving the records.
+  Sink sink_{};
+
+  /// ID of the entry being processed.
+  std::uint64_t current_id_ = 0;
+};
+
+/**
+ * Trace sink keeping the most recent records in memory, overwriting the
+ * oldest records once full. Writing a record is a copy into a preallocated
+ * buffer.
+ *
+ * @tparam Capacity Maximum number of records. Must be a power of two.
+ */
+template <std::size_t Capacity = 65536> class trace_ring {
+  static_assert(std::has_single_bit(Capacity));
+
+public:
+  /// Constructor.
+  trace_ring() : records_(Capacity) {}
+
+  /// @param record Record to add, replacing the oldest record if full.
+  void write(const trace_record &record) {
+    records_[n_written_ & (Capacity - 1)] = record;
+    ++n_written_;
+  }
+
+  /// @return Number of kept records.
+  std::size_t size() const {
+    return static_cast<std::size_t>(std::min<std::uint64_t>(n_written_,
+                                                            Capacity));
+  }
+
+  /// @return Number of overwritten records.
+  std::uint64_t dropped() const { return n_written_ - size(); }
+
+  /**
+   * @param i Index of the record, where 0 is the oldest kept record.
+   * @return Reference to the record.
+   */
+  const trace_record &operator[](std::size_t i) const {
+    return records_[(dropped() + i) & (Capacity - 1)];
+  }
+
+private:
+  /// Records, indexed by their number modulo the capacity.
+  std::vector<trace_record> records_;
+
+  /// Number of written records.
+  std::uint64_t n_written_ = 0;
+};
+} // namespace simcpp20
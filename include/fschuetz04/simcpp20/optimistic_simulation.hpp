@@ -0,0 +1,467 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm>  // std::min
+#include <barrier>    // std::barrier
+#include <cassert>    // assert
+#include <compare>    // operator<=>
+#include <cstddef>    // std::size_t, std::ptrdiff_t
+#include <cstdint>    // std::uint64_t
+#include <deque>      // std::deque
+#include <exception>  // std::exception_ptr, std::rethrow_exception
+#include <functional> // std::function, std::ref
+#include <map>        // std::map
+#include <memory>     // std::unique_ptr
+#include <mutex>      // std::mutex, std::lock_guard
+#include <optional>   // std::optional
+#include <thread>     // std::thread
+#include <utility>    // std::exchange, std::move, std::pair
+#include <vector>     // std::vector
+
+namespace simcpp20 {
+/**
+ * Simulation partitioned into logical processes, which are executed
+ * optimistically in parallel using Time Warp.
+ *
+ * In contrast to partitioned_simulation, messages do not need a lookahead.
+ * Each logical process processes its messages speculatively in timestamp
+ * order. When a message arrives in the past of a logical process (a
+ * straggler), the logical process is rolled back: Its state is restored, the
+ * messages sent by the rolled back handlers are cancelled using anti-messages
+ * and the rolled back messages are processed again.
+ *
+ * Since the frames of suspended coroutines cannot be saved and restored, this
+ * mode is restricted: Each logical process consists of a copyable state and a
+ * handler which is called once per received message. The handler may only
+ * modify the state and send messages, because other side effects are not
+ * undone on rollback. The state is copied before each call of the handler, so
+ * it should be small.
+ *
+ * Periodically, all logical processes stop to compute the global virtual time
+ * (GVT), which is the minimum time of all unprocessed messages. Messages
+ * before it are never rolled back, so their saved states are released.
+ *
+ * Messages received at the same time are processed in the order of their
+ * sender, their sending time and the order in which the handler sent them.
+ *
+ * @tparam State Type of the state of one logical process. Must be copyable.
+ * @tparam Message Type of the messages. Must be copyable.
+ * @tparam Time Type used for simulation time.
+ */
+template <typename State, typename Message, typename Time = double>
+class optimistic_simulation {
+public:
+  class logical_process;
+
+  /// Type of the handler called for each message.
+  using handler_type =
+      std::function<void(logical_process &, State &, const Message &)>;
+
+  /**
+   * One partition of the simulation, running on its own thread. Passed to the
+   * handler to send messages.
+   */
+  class logical_process {
+  public:
+    /// @return Receive time of the message being handled.
+    Time now() const { return now_; }
+
+    /// @return Index of the logical process.
+    std::size_t id() const { return id_; }
+
+    /**
+     * Send a message to a logical process, which may be this one. Must only
+     * be called by the handler.
+     *
+     * @param to Index of the receiving logical process.
+     * @param msg Message.
+     * @param delay Delay after which the message is received. Must be
+     * positive.
+     */
+    void send(std::size_t to, Message msg, Time delay) {
+      assert(to < psim_.size());
+      assert(delay > Time{0});
+
+      key k{now_ + delay, id_, now_, n_sent_++};
+      auto uid = next_uid_++;
+      outputs_.push_back(output{to, k, uid});
+      psim_.lps_[to]->post(envelope{k, uid, std::move(msg)});
+    }
+
+    /// @return Current state. Only consistent while the simulation is paused.
+    const State &state() const { return state_; }
+
+    /// @return Number of handled messages which were rolled back.
+    std::size_t rollbacks() const { return rollbacks_; }
+
+  private:
+    /// Order of the messages at their receiver.
+    struct key {
+      /// Receive time.
+      Time time_;
+
+      /// Index of the sending logical process.
+      std::size_t from_;
+
+      /// Sending time.
+      Time sent_at_;
+
+      /// Number of messages sent before by the same handler call.
+      std::size_t index_;
+
+      auto operator<=>(const key &) const = default;
+    };
+
+    /// Message in transit. Anti-messages have no message.
+    struct envelope {
+      /// Order of the message.
+      key key_;
+
+      /// Identifier of the message, unique for the sender.
+      std::uint64_t uid_;
+
+      /// Message, if this is no anti-message.
+      std::optional<Message> msg_;
+    };
+
+    /// Identifier of a message in the pending and processed messages.
+    using id_type = std::pair<key, std::uint64_t>;
+
+    /// Message sent while handling a message.
+    struct output {
+      /// Index of the receiving logical process.
+      std::size_t to_;
+
+      /// Order of the message.
+      key key_;
+
+      /// Identifier of the message.
+      std::uint64_t uid_;
+    };
+
+    /// Handled message, together with the data needed to roll it back.
+    struct processed {
+      /// Identifier of the message.
+      id_type id_;
+
+      /// Message.
+      Message msg_;
+
+      /// State before handling the message.
+      State before_;
+
+      /// Messages sent while handling the message.
+      std::vector<output> outputs_;
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param psim Reference to the optimistic simulation.
+     * @param id Index of the logical process.
+     * @param state Initial state.
+     */
+    logical_process(optimistic_simulation &psim, std::size_t id, State state)
+        : psim_{psim}, id_{id}, state_{std::move(state)} {}
+
+    /// @param env Message to add to the inbox. Called by any thread.
+    void post(envelope env) {
+      std::lock_guard lock{inbox_mutex_};
+      inbox_.push_back(std::move(env));
+    }
+
+    /// Move all messages from the inbox to the pending messages.
+    void drain() {
+      std::vector<envelope> received;
+      {
+        std::lock_guard lock{inbox_mutex_};
+        std::swap(received, inbox_);
+      }
+
+      for (auto &env : received) {
+        id_type id{env.key_, env.uid_};
+        if (!processed_.empty() && id <= processed_.back().id_) {
+          // straggler or anti-message of a handled message
+          rollback(id);
+        }
+
+        if (env.msg_) {
+          pending_.emplace(id, std::move(*env.msg_));
+        } else {
+          // the message is sent before its anti-message, so it is pending
+          auto erased = pending_.erase(id);
+          assert(erased == 1);
+          (void)erased;
+        }
+      }
+    }
+
+    /**
+     * Roll back all handled messages not before the given message.
+     *
+     * @param id Identifier of the message.
+     */
+    void rollback(const id_type &id) {
+      while (!processed_.empty() && !(processed_.back().id_ < id)) {
+        auto &entry = processed_.back();
+        state_ = std::move(entry.before_);
+        for (auto &out : entry.outputs_) {
+          psim_.lps_[out.to_]->post(envelope{out.key_, out.uid_, {}});
+        }
+
+        pending_.emplace(entry.id_, std::move(entry.msg_));
+        processed_.pop_back();
+        ++rollbacks_;
+      }
+    }
+
+    /**
+     * Handle pending messages in timestamp order.
+     *
+     * @param target Time at which to stop.
+     * @param n Maximum number of messages to handle.
+     */
+    void process(Time target, std::size_t n) {
+      for (std::size_t i = 0; i < n && !pending_.empty(); ++i) {
+        auto it = pending_.begin();
+        if (it->first.first.time_ >= target) {
+          return;
+        }
+
+        processed entry{it->first, std::move(it->second), state_, {}};
+        pending_.erase(it);
+
+        now_ = entry.id_.first.time_;
+        n_sent_ = 0;
+        outputs_.clear();
+        psim_.handler_(*this, state_, entry.msg_);
+
+        entry.outputs_ = std::move(outputs_);
+        processed_.push_back(std::move(entry));
+      }
+    }
+
+    /**
+     * @return Minimum time of all pending messages and all messages in the
+     * inbox, if any. Must only be called while no thread sends messages.
+     */
+    std::optional<Time> min_time() {
+      std::optional<Time> min;
+      if (!pending_.empty()) {
+        min = pending_.begin()->first.first.time_;
+      }
+
+      std::lock_guard lock{inbox_mutex_};
+      for (auto &env : inbox_) {
+        min = min ? std::min(*min, env.key_.time_) : env.key_.time_;
+      }
+
+      return min;
+    }
+
+    /**
+     * Release the saved states of all handled messages before the GVT.
+     *
+     * @param gvt Global virtual time.
+     */
+    void collect(Time gvt) {
+      while (!processed_.empty() && processed_.front().id_.first.time_ < gvt) {
+        processed_.pop_front();
+      }
+    }
+
+    /// Reference to the optimistic simulation.
+    optimistic_simulation &psim_;
+
+    /// Index of the logical process.
+    std::size_t id_;
+
+    /// Current state.
+    State state_;
+
+    /// Receive time of the message being handled.
+    Time now_{};
+
+    /// Number of messages sent by the current handler call.
+    std::size_t n_sent_ = 0;
+
+    /// Messages sent by the current handler call.
+    std::vector<output> outputs_{};
+
+    /// Next identifier of a sent message.
+    std::uint64_t next_uid_ = 0;
+
+    /// Received messages which are not handled, in timestamp order.
+    std::map<id_type, Message> pending_{};
+
+    /// Handled messages after the GVT, in timestamp order.
+    std::deque<processed> processed_{};
+
+    /// Messages sent to this logical process and not drained yet.
+    std::vector<envelope> inbox_{};
+
+    /// Mutex protecting inbox_.
+    std::mutex inbox_mutex_{};
+
+    /// Number of handled messages which were rolled back.
+    std::size_t rollbacks_ = 0;
+
+    friend class optimistic_simulation;
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param states Initial states, one per logical process.
+   * @param handler Handler called for each message. Called concurrently from
+   * multiple threads.
+   * @param batch Number of messages each logical process handles between two
+   * computations of the GVT.
+   */
+  optimistic_simulation(std::vector<State> states, handler_type handler,
+                        std::size_t batch = 256)
+      : handler_{std::move(handler)}, batch_{batch} {
+    assert(!states.empty());
+    assert(batch_ > 0);
+
+    lps_.reserve(states.size());
+    for (std::size_t i = 0; i < states.size(); ++i) {
+      lps_.emplace_back(new logical_process{*this, i, std::move(states[i])});
+    }
+  }
+
+  optimistic_simulation(const optimistic_simulation &) = delete;
+  optimistic_simulation &operator=(const optimistic_simulation &) = delete;
+
+  /**
+   * @param i Index of the logical process.
+   * @return Reference to the logical process.
+   */
+  const logical_process &operator[](std::size_t i) const {
+    assert(i < size());
+    return *lps_[i];
+  }
+
+  /// @return Number of logical processes.
+  std::size_t size() const { return lps_.size(); }
+
+  /**
+   * Send an initial message to a logical process. Must not be called while
+   * the simulation is running.
+   *
+   * @param to Index of the receiving logical process.
+   * @param msg Message.
+   * @param time Receive time. Must not be before the time the simulation was
+   * run until.
+   */
+  void send(std::size_t to, Message msg, Time time) {
+    assert(to < size());
+    assert(time >= gvt_);
+
+    // initial messages use the index after the last logical process as sender
+    auto uid = next_initial_++;
+    key k{time, size(), gvt_, uid};
+    lps_[to]->post(envelope{k, uid, std::move(msg)});
+  }
+
+  /**
+   * Run all logical processes in parallel until all messages before the
+   * target time are handled. Afterwards, the states of the logical processes
+   * reflect exactly the messages received before the target time.
+   *
+   * If a handler throws an exception, all logical processes stop at the next
+   * computation of the GVT and the first exception is rethrown. The states
+   * may be inconsistent afterwards.
+   *
+   * @param target Target time.
+   */
+  void run_until(Time target) {
+    auto next_round = [this, target]() noexcept {
+      std::optional<Time> gvt;
+      for (auto &lp : lps_) {
+        if (auto min = lp->min_time()) {
+          gvt = gvt ? std::min(*gvt, *min) : *min;
+        }
+      }
+
+      done_ = error_ != nullptr || !gvt || *gvt >= target;
+      gvt_ = gvt ? std::min(*gvt, target) : target;
+    };
+
+    std::barrier sync{static_cast<std::ptrdiff_t>(size()), next_round};
+
+    auto work = [&](logical_process &lp) {
+      while (true) {
+        try {
+          lp.drain();
+          lp.process(target, batch_);
+        } catch (...) {
+          std::lock_guard lock{error_mutex_};
+          if (error_ == nullptr) {
+            error_ = std::current_exception();
+          }
+        }
+
+        sync.arrive_and_wait();
+        if (done_) {
+          break;
+        }
+
+        lp.collect(gvt_);
+      }
+
+      lp.collect(gvt_);
+    };
+
+    // the calling thread runs the first logical process
+    std::vector<std::thread> threads;
+    threads.reserve(size() - 1);
+    for (std::size_t i = 1; i < size(); ++i) {
+      threads.emplace_back(work, std::ref(*lps_[i]));
+    }
+
+    work(*lps_[0]);
+
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    if (error_ != nullptr) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+private:
+  /// Order of the messages at their receiver.
+  using key = typename logical_process::key;
+
+  /// Message in transit.
+  using envelope = typename logical_process::envelope;
+
+  /// Handler called for each message.
+  handler_type handler_;
+
+  /// Number of messages handled between two computations of the GVT.
+  std::size_t batch_;
+
+  /// Logical processes.
+  std::vector<std::unique_ptr<logical_process>> lps_{};
+
+  /// Global virtual time. Only written between rounds.
+  Time gvt_{};
+
+  /// Whether to stop after the current round. Only written between rounds.
+  bool done_ = false;
+
+  /// Number of initial messages.
+  std::uint64_t next_initial_ = 0;
+
+  /// First exception thrown by a handler.
+  std::exception_ptr error_ = nullptr;
+
+  /// Mutex protecting error_ while processing a round.
+  std::mutex error_mutex_{};
+};
+} // namespace simcpp20
@@ -0,0 +1,284 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm>  // std::min
+#include <barrier>    // std::barrier
+#include <cassert>    // assert
+#include <cstddef>    // std::size_t, std::ptrdiff_t
+#include <exception>  // std::exception_ptr, std::rethrow_exception
+#include <functional> // std::ref
+#include <memory>     // std::unique_ptr
+#include <mutex>      // std::mutex, std::lock_guard
+#include <optional>   // std::optional
+#include <thread>     // std::thread
+#include <utility>    // std::exchange, std::move, std::pair
+#include <vector>     // std::vector
+
+#include "policy.hpp"
+#include "simulation.hpp"
+#include "store.hpp"
+#include "value_event.hpp"
+
+namespace simcpp20 {
+/**
+ * Simulation partitioned into logical processes, which run in parallel on
+ * separate threads and exchange timestamped messages.
+ *
+ * Each logical process owns a regular simulation, so the processes of a model
+ * are written as usual. Logical processes only interact by sending messages,
+ * which are received by awaiting the value event returned by receive:
+ *
+ *     simcpp20::partitioned_simulation<int> psim{2, 1.0};
+ *
+ *     simcpp20::event<> ping(decltype(psim)::logical_process &lp) {
+ *       while (true) {
+ *         lp.send(1, 42, 1.0);
+ *         int reply = co_await lp.receive();
+ *       }
+ *     }
+ *
+ * The logical processes are synchronized conservatively in windows. Every
+ * message is sent with a delay of at least the lookahead. Thus, given the time
+ * of the earliest event of all logical processes, no message can arrive
+ * before that time plus the lookahead, and all logical processes process
+ * their events up to this window end independently. Afterwards, the messages
+ * sent during the window are delivered and the next window is computed.
+ *
+ * Messages are buffered per pair of sender and receiver. Each buffer is only
+ * written by the sender while processing a window and only read by the
+ * receiver between windows, so sending does not need any locking.
+ *
+ * Messages are delivered in a deterministic order, so runs do not depend on
+ * thread scheduling.
+ *
+ * @tparam Message Type of the messages. Must be move constructible.
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulations.
+ */
+template <typename Message, typename Time = double,
+          typename Policy = default_policy>
+class partitioned_simulation {
+public:
+  /// One partition of the simulation, running on its own thread.
+  class logical_process {
+  public:
+    /// @return Index of the logical process.
+    std::size_t id() const { return id_; }
+
+    /**
+     * Send a message to a logical process, which may be this one.
+     *
+     * @param to Index of the receiving logical process.
+     * @param msg Message.
+     * @param delay Delay after which the message is received. Must be at
+     * least the lookahead.
+     */
+    void send(std::size_t to, Message msg, Time delay) {
+      assert(to < psim_.size());
+      assert(delay >= psim_.lookahead());
+
+      psim_.channel(id_, to).emplace_back(sim_.now() + delay, std::move(msg));
+    }
+
+    /**
+     * @return Pending value event which is triggered with the next received
+     * message. Messages are taken in the order they are received.
+     */
+    value_event<Message, Time, Policy> receive() { return inbox_.get(); }
+
+    /// @return Number of received messages which are not taken yet.
+    std::size_t queued() const { return inbox_.size(); }
+
+  private:
+    /**
+     * Constructor.
+     *
+     * @param psim Reference to the partitioned simulation.
+     * @param id Index of the logical process.
+     */
+    logical_process(partitioned_simulation &psim, std::size_t id)
+        : sim{sim_}, psim_{psim}, id_{id} {}
+
+    /// Schedule all messages sent to this logical process since the last call.
+    void deliver() {
+      for (std::size_t from = 0; from < psim_.size(); ++from) {
+        auto &msgs = psim_.channel(from, id_);
+        for (auto &[time, msg] : msgs) {
+          auto ev = sim_.timeout(time - sim_.now());
+          ev.add_callback([this, msg = std::move(msg)](const auto &) mutable {
+            inbox_.put(std::move(msg));
+          });
+        }
+        msgs.clear();
+      }
+    }
+
+    /// Simulation of the logical process.
+    simulation<Time, Policy> sim_{};
+
+  public:
+    /**
+     * Reference to the simulation of the logical process. Coroutine functions
+     * taking the logical process as their first argument use this simulation.
+     */
+    simulation<Time, Policy> &sim;
+
+  private:
+    /// Reference to the partitioned simulation.
+    partitioned_simulation &psim_;
+
+    /// Index of the logical process.
+    std::size_t id_;
+
+    /// Received messages.
+    store<Message, Time, Policy> inbox_{sim_};
+
+    friend class partitioned_simulation;
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param n Number of logical processes.
+   * @param lookahead Minimum delay of all messages. Must be positive.
+   */
+  partitioned_simulation(std::size_t n, Time lookahead)
+      : lookahead_{lookahead}, channels_(n * n) {
+    assert(n > 0);
+    assert(lookahead > Time{0});
+
+    lps_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      lps_.emplace_back(new logical_process{*this, i});
+    }
+  }
+
+  partitioned_simulation(const partitioned_simulation &) = delete;
+  partitioned_simulation &operator=(const partitioned_simulation &) = delete;
+
+  /**
+   * @param i Index of the logical process.
+   * @return Reference to the logical process.
+   */
+  logical_process &operator[](std::size_t i) {
+    assert(i < size());
+    return *lps_[i];
+  }
+
+  /// @return Number of logical processes.
+  std::size_t size() const { return lps_.size(); }
+
+  /// @return Minimum delay of all messages.
+  Time lookahead() const { return lookahead_; }
+
+  /**
+   * Run all logical processes in parallel until the target time is reached or
+   * no more events are scheduled and no messages are in transit. Afterwards,
+   * the simulation time of all logical processes is the target time.
+   *
+   * If processing an event of a logical process throws an exception, all
+   * logical processes stop after the current window and the first exception
+   * is rethrown.
+   *
+   * @param target Target time.
+   */
+  void run_until(Time target) {
+    // computes the next window once all logical processes delivered their
+    // messages, before any of them continues
+    auto next_window = [this, target]() noexcept {
+      std::optional<Time> next;
+      for (auto &lp : lps_) {
+        if (!lp->sim_.empty()) {
+          auto time = lp->sim_.next_time();
+          next = next ? std::min(*next, time) : time;
+        }
+      }
+
+      done_ = error_ != nullptr || !next || *next >= target;
+      if (!done_) {
+        window_end_ = std::min(*next + lookahead_, target);
+      }
+    };
+
+    std::barrier sync{static_cast<std::ptrdiff_t>(size()), next_window};
+    std::barrier exchange{static_cast<std::ptrdiff_t>(size())};
+
+    auto work = [&](logical_process &lp) {
+      while (true) {
+        lp.deliver();
+        sync.arrive_and_wait();
+        if (done_) {
+          break;
+        }
+
+        try {
+          lp.sim_.run_until(window_end_);
+        } catch (...) {
+          std::lock_guard lock{error_mutex_};
+          if (error_ == nullptr) {
+            error_ = std::current_exception();
+          }
+        }
+
+        exchange.arrive_and_wait();
+      }
+
+      if (error_ == nullptr && lp.sim_.now() < target) {
+        lp.sim_.run_until(target);
+      }
+    };
+
+    // the calling thread runs the first logical process
+    std::vector<std::thread> threads;
+    threads.reserve(size() - 1);
+    for (std::size_t i = 1; i < size(); ++i) {
+      threads.emplace_back(work, std::ref(*lps_[i]));
+    }
+
+    work(*lps_[0]);
+
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    if (error_ != nullptr) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+private:
+  /**
+   * @param from Index of the sending logical process.
+   * @param to Index of the receiving logical process.
+   * @return Reference to the messages in transit from one logical process to
+   * another, together with their receive times.
+   */
+  std::vector<std::pair<Time, Message>> &channel(std::size_t from,
+                                                 std::size_t to) {
+    return channels_[from * size() + to];
+  }
+
+  /// Minimum delay of all messages.
+  Time lookahead_;
+
+  /// Messages in transit, per pair of sender and receiver.
+  std::vector<std::vector<std::pair<Time, Message>>> channels_;
+
+  /// Logical processes.
+  std::vector<std::unique_ptr<logical_process>> lps_{};
+
+  /// End of the current window. Only written between windows.
+  Time window_end_{};
+
+  /// Whether to stop after the current window. Only written between windows.
+  bool done_ = false;
+
+  /// First exception thrown while processing a window.
+  std::exception_ptr error_ = nullptr;
+
+  /// Mutex protecting error_ while processing a window.
+  std::mutex error_mutex_{};
+};
+} // namespace simcpp20
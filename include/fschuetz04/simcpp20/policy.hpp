@@ -0,0 +1,66 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <any> // std::any
+
+#include "allocator.hpp"
+#include "observer.hpp"
+#include "queue.hpp"
+
+namespace simcpp20 {
+/**
+ * Default policy of a simulation. Selects the implementations used by the
+ * simulation internally.
+ *
+ * To change some of the implementations, derive from this class and replace
+ * the corresponding members:
+ *
+ *     struct calendar_policy : simcpp20::default_policy {
+ *       template <typename Item> using queue = simcpp20::calendar_queue<Item>;
+ *     };
+ *
+ *     simcpp20::simulation<double, calendar_policy> sim;
+ */
+struct default_policy {
+  /**
+   * Event queue holding the scheduled events. Must provide push, top, pop,
+   * empty and size. If it provides push_batch or remove_if, these are used
+   * for scheduling multiple events at once and for removing the entries of
+   * aborted events. By default, a radix heap is used if the simulation time is
+   * integral and a binary heap otherwise.
+   *
+   * @tparam Item Type of the scheduled events.
+   */
+  template <typename Item> using queue = default_queue<Item>;
+
+  /// Allocator for the shared data of events and coroutine frames.
+  using allocator = pool_allocator;
+
+  /**
+   * Whether processes start running immediately when called, instead of
+   * being resumed at the current simulation time after all events already
+   * scheduled for that time.
+   */
+  static constexpr bool eager_start = false;
+
+  /**
+   * Whether a returning process resumes the coroutine awaiting it directly,
+   * if exactly one coroutine and nothing else awaits it. Otherwise, the event
+   * of the process is triggered and the awaiting coroutine is resumed when
+   * the event is processed, after all events already scheduled for the
+   * current simulation time.
+   */
+  static constexpr bool symmetric_transfer = false;
+
+  /// Type of the cause passed to a process when it is interrupted.
+  using interrupt_cause = std::any;
+
+  /**
+   * Observer called at hooks in the scheduler and the events, for example
+   * counting_observer or trace_observer. See null_observer.
+   */
+  using observer = null_observer;
+};
+} // namespace simcpp20
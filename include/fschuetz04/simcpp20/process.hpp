@@ -0,0 +1,500 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert>     // assert
+#include <concepts>    // std::derived_from
+#include <coroutine>   // std::coroutine_handle, std::noop_coroutine, ...
+#include <cstddef>     // std::size_t
+#include <optional>    // std::optional
+#include <type_traits> // std::decay_t, std::remove_reference_t, ...
+#include <utility>     // std::declval, std::forward, std::move
+
+#include "event.hpp"
+#include "ring_buffer.hpp"
+#include "simulation.hpp"
+
+namespace simcpp20 {
+/**
+ * Result of using co_await inside a process. Holds either the result of the
+ * awaited event or the cause of an interrupt.
+ *
+ * @tparam Value Type of the value of the awaited event, or void.
+ * @tparam Cause Type of the interrupt cause.
+ */
+template <typename Value, typename Cause> class await_result {
+public:
+  /**
+   * @param value Value of the awaited event.
+   * @return Result of an event which is processed.
+   */
+  static await_result from_value(Value &value) {
+    await_result result;
+    result.value_ = &value;
+    return result;
+  }
+
+  /**
+   * @param cause Cause of the interrupt.
+   * @return Result of an interrupt.
+   */
+  static await_result from_cause(Cause cause) {
+    await_result result;
+    result.cause_.emplace(std::move(cause));
+    return result;
+  }
+
+  /// @return Whether the process was interrupted.
+  bool interrupted() const { return cause_.has_value(); }
+
+  /// @return Whether the awaited event is processed.
+  explicit operator bool() const { return !interrupted(); }
+
+  /// @return Value of the awaited event.
+  Value &value() const {
+    assert(!interrupted());
+    return *value_;
+  }
+
+  /// @return Value of the awaited event.
+  Value &operator*() const { return value(); }
+
+  /// @return Cause of the interrupt.
+  Cause &cause() {
+    assert(interrupted());
+    return *cause_;
+  }
+
+private:
+  /// Constructor.
+  await_result() = default;
+
+  /// Value of the awaited event, if processed.
+  Value *value_ = nullptr;
+
+  /// Cause of the interrupt, if interrupted.
+  std::optional<Cause> cause_ = {};
+};
+
+/**
+ * Result of using co_await on an event without a value inside a process.
+ *
+ * @tparam Cause Type of the interrupt cause.
+ */
+template <typename Cause> class await_result<void, Cause> {
+public:
+  /// @return Result of an event which is processed.
+  static await_result from_value() { return await_result{}; }
+
+  /**
+   * @param cause Cause of the interrupt.
+   * @return Result of an interrupt.
+   */
+  static await_result from_cause(Cause cause) {
+    await_result result;
+    result.cause_.emplace(std::move(cause));
+    return result;
+  }
+
+  /// @return Whether the process was interrupted.
+  bool interrupted() const { return cause_.has_value(); }
+
+  /// @return Whether the awaited event is processed.
+  explicit operator bool() const { return !interrupted(); }
+
+  /// @return Cause of the interrupt.
+  Cause &cause() {
+    assert(interrupted());
+    return *cause_;
+  }
+
+private:
+  /// Constructor.
+  await_result() = default;
+
+  /// Cause of the interrupt, if interrupted.
+  std::optional<Cause> cause_ = {};
+};
+
+/**
+ * Event of a process which can be interrupted.
+ *
+ * A process is a coroutine function returning this type. Inside a process,
+ * co_await returns an await_result instead of throwing an exception when the
+ * process is interrupted:
+ *
+ *     simcpp20::process<> worker(simcpp20::simulation<> &sim) {
+ *       auto result = co_await sim.timeout(10);
+ *       if (result.interrupted()) {
+ *         // use result.cause()
+ *       }
+ *     }
+ *
+ * Interrupting a process removes it from the event it awaits and resumes it
+ * at the current simulation time, like any other event would. If the process
+ * does not await an event when it is interrupted, the interrupt is delivered
+ * at its next co_await. Only events and delays can be awaited inside a
+ * process. Delays are converted to timeouts, so the process can be removed
+ * from them.
+ *
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulation.
+ */
+template <typename Time, typename Policy>
+class process : public event<Time, Policy> {
+private:
+  using event_type = simcpp20::event<Time, Policy>;
+
+public:
+  /// Type of the interrupt cause.
+  using cause_type = typename Policy::interrupt_cause;
+
+  /**
+   * Constructor.
+   *
+   * @param simulation Reference to the simulation.
+   */
+  explicit process(simulation<Time, Policy> &sim)
+      : event_type{new (sim) data(sim)} {}
+
+  /**
+   * Interrupt the process. If the process already returned or is aborted,
+   * nothing is done.
+   *
+   * @param cause Cause of the interrupt, returned by the co_await expression
+   * of the interrupted process.
+   */
+  void interrupt(cause_type cause = {}) const {
+    assert(event_type::awaiting_ev_ == nullptr);
+    assert(event_type::data_ != nullptr);
+
+    auto casted_data = static_cast<data *>(event_type::data_);
+    if (!event_type::pending() || !casted_data->handle_) {
+      return;
+    }
+
+    casted_data->causes_.push_back(std::move(cause));
+
+    auto awaited = std::exchange(casted_data->awaited_, nullptr);
+    if (awaited == nullptr) {
+      return;
+    }
+
+    auto &handles = awaited->handles_;
+    for (auto it = handles.begin(); it != handles.end(); ++it) {
+      if (it->handle_ == casted_data->handle_) {
+        handles.erase(it);
+        break;
+      }
+    }
+
+    // the awaited event was released when the process was suspended and is
+    // taken again when it is resumed, see interruptible::await_resume
+    awaited->use_count_ += 1;
+
+    auto handle = casted_data->handle_;
+    casted_data->sim_.schedule(handle, handle.promise().ev_, Time{0});
+  }
+
+  /// Promise type for a process.
+  class promise_type {
+  public:
+    /**
+     * Constructor.
+     *
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param sim Reference to the simulation.
+     */
+    template <typename... Args>
+    explicit promise_type(simulation<Time, Policy> &sim, Args &&...)
+        : sim_{sim}, ev_{sim} {}
+
+    /**
+     * Constructor.
+     *
+     * @tparam Class Class type if the coroutine function is a lambda or a
+     * member function of a class.
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param sim Reference to the simulation.
+     */
+    template <typename Class, typename... Args>
+    explicit promise_type(Class &&, simulation<Time, Policy> &sim, Args &&...)
+        : sim_{sim}, ev_{sim} {}
+
+    /**
+     * Constructor.
+     *
+     * @tparam Class Class type if the coroutine function is a member function
+     * of a class. Must contain a member variable sim referencing the simulation
+     * instance.
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param c Class instance.
+     */
+    template <typename Class, typename... Args>
+    explicit promise_type(Class &&c, Args &&...) : sim_{c.sim}, ev_{c.sim} {}
+
+    /**
+     * Destructor. Called when the coroutine frame is destroyed, so the
+     * process can no longer be interrupted.
+     */
+    ~promise_type() {
+      auto casted_data = static_cast<data *>(ev_.data_);
+      casted_data->handle_ = nullptr;
+      casted_data->awaited_ = nullptr;
+    }
+
+    /**
+     * Allocate the coroutine frame using the allocator of the simulation.
+     *
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame in bytes.
+     * @param sim Reference to the simulation.
+     * @return Pointer to the coroutine frame.
+     */
+    template <typename... Args>
+    static void *operator new(std::size_t size, simulation<Time, Policy> &sim,
+                              Args &&...) {
+      return allocate_frame(&sim.allocator(), size);
+    }
+
+    /**
+     * Allocate the coroutine frame using the allocator of the simulation.
+     *
+     * @tparam Class Class type if the coroutine function is a lambda or a
+     * member function of a class.
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame in bytes.
+     * @param sim Reference to the simulation.
+     * @return Pointer to the coroutine frame.
+     */
+    template <typename Class, typename... Args>
+    static void *operator new(std::size_t size, Class &&,
+                              simulation<Time, Policy> &sim, Args &&...) {
+      return allocate_frame(&sim.allocator(), size);
+    }
+
+    /**
+     * Allocate the coroutine frame using the allocator of the simulation.
+     *
+     * @tparam Class Class type if the coroutine function is a member function
+     * of a class. Must contain a member variable sim referencing the simulation
+     * instance.
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame in bytes.
+     * @param c Class instance.
+     * @return Pointer to the coroutine frame.
+     */
+    template <typename Class, typename... Args>
+    static void *operator new(std::size_t size, Class &&c, Args &&...) {
+      return allocate_frame(&c.sim.allocator(), size);
+    }
+
+    /**
+     * Deallocate the coroutine frame.
+     *
+     * @param ptr Pointer to the coroutine frame.
+     * @param size Size of the coroutine frame in bytes.
+     */
+    SIMCPP20_FRAME_DELETE static void operator delete(void *ptr,
+                                                      std::size_t size) {
+      deallocate_frame<typename Policy::allocator>(ptr, size);
+    }
+
+#ifdef __INTELLISENSE__
+    // IntelliSense fix. See https://stackoverflow.com/q/67209981.
+    promise_type();
+#endif
+
+    /**
+     * Called to get the return value of the coroutine function.
+     *
+     * @return Process associated with the coroutine. Its event is triggered
+     * when the coroutine returns.
+     */
+    process<Time, Policy> get_return_object() {
+      static_cast<data *>(ev_.data_)->handle_ =
+          std::coroutine_handle<promise_type>::from_promise(*this);
+      return ev_;
+    }
+
+    /**
+     * Called when the coroutine is started. Unless the policy requests an
+     * eager start, the coroutine awaits the return value before running.
+     *
+     * @return Awaitable which is always ready if the start is eager, otherwise
+     * a delay of 0, so the coroutine runs at the current simulation time after
+     * all events already scheduled for that time.
+     */
+    auto initial_suspend() const {
+      if constexpr (Policy::eager_start) {
+        return std::suspend_never{};
+      } else {
+        return sim_.delay(Time{0});
+      }
+    }
+
+    /// Called when an exception is thrown inside the coroutine and not handled.
+    void unhandled_exception() const { assert(false); }
+
+    /**
+     * Called when the coroutine returns. Trigger the event associated with the
+     * coroutine. If the policy enables symmetric transfer and exactly one
+     * coroutine awaits the event, that coroutine is resumed directly instead.
+     */
+    void return_void() {
+      if constexpr (Policy::symmetric_transfer) {
+        next_ = ev_.trigger_or_transfer();
+      } else {
+        ev_.trigger();
+      }
+    }
+
+    /**
+     * Called after the coroutine returns.
+     *
+     * @return Awaitable transferring control to the coroutine to resume next
+     * if the policy enables symmetric transfer, otherwise awaitable which is
+     * always ready.
+     */
+    auto final_suspend() const noexcept {
+      if constexpr (Policy::symmetric_transfer) {
+        return typename event_type::final_awaitable{next_};
+      } else {
+        return std::suspend_never{};
+      }
+    }
+
+    /**
+     * Called when using co_await inside the process.
+     *
+     * @tparam Awaitable Type of the awaited event.
+     * @param awaitable Awaited event.
+     * @return Awaitable returning an await_result.
+     */
+    template <typename Awaitable>
+      requires std::derived_from<std::decay_t<Awaitable>, event_type>
+    auto await_transform(Awaitable &&awaitable) {
+      return interruptible<std::decay_t<Awaitable>>{
+          *static_cast<data *>(ev_.data_), std::forward<Awaitable>(awaitable)};
+    }
+
+    /**
+     * Called when using co_await on a delay inside the process. The delay is
+     * converted to a timeout, so the process can be removed from it when it
+     * is interrupted.
+     *
+     * @param delay Awaited delay.
+     * @return Awaitable returning an await_result.
+     */
+    auto
+    await_transform(typename simulation<Time, Policy>::delay_awaitable delay) {
+      return await_transform(event_type{delay});
+    }
+
+    /// Reference to the simulation.
+    simulation<Time, Policy> &sim_;
+
+    /**
+     * Process associated with the coroutine. Its event is triggered when the
+     * coroutine returns.
+     */
+    process<Time, Policy> ev_;
+
+    /// Coroutine to resume after this coroutine returns.
+    std::coroutine_handle<> next_ = std::noop_coroutine();
+  };
+
+private:
+  /// Shared data of the process.
+  class data : public event_type::data {
+  public:
+    using event_type::data::data;
+
+    /// Handle of the coroutine, if not destroyed yet.
+    std::coroutine_handle<promise_type> handle_ = nullptr;
+
+    /// Shared data of the event the coroutine is suspended on, if any.
+    typename event_type::data *awaited_ = nullptr;
+
+    /// Causes of interrupts which are not delivered yet.
+    detail::ring_buffer<cause_type> causes_ = {};
+  };
+
+  /**
+   * Awaitable wrapping an event awaited inside the process.
+   *
+   * @tparam Awaitable Type of the awaited event.
+   */
+  template <typename Awaitable> class interruptible {
+  private:
+    /// Return type of co_await on the event.
+    using value_type = std::remove_reference_t<
+        decltype(std::declval<Awaitable &>().await_resume())>;
+
+  public:
+    /**
+     * Constructor.
+     *
+     * @param process_data Shared data of the process.
+     * @param ev Awaited event.
+     */
+    interruptible(data &process_data, Awaitable ev)
+        : data_{process_data}, ev_{std::move(ev)} {}
+
+    /**
+     * @return Whether the process can continue without being suspended, which
+     * is the case if the event is processed or an interrupt is pending.
+     */
+    bool await_ready() { return !data_.causes_.empty() || ev_.await_ready(); }
+
+    /**
+     * @tparam Promise Promise type of the process.
+     * @param handle Handle of the process.
+     */
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) {
+      // set before suspending, since the process is destroyed if the event is
+      // aborted or released
+      data_.awaited_ = ev_.data_;
+      ev_.await_suspend(handle);
+    }
+
+    /// @return Result of the event or cause of the interrupt.
+    await_result<value_type, cause_type> await_resume() {
+      data_.awaited_ = nullptr;
+
+      if (!data_.causes_.empty()) {
+        auto cause = std::move(data_.causes_.front());
+        data_.causes_.pop_front();
+
+        // the event was taken again by interrupt, if awaited
+        ev_.awaiting_ev_ = nullptr;
+        return await_result<value_type, cause_type>::from_cause(
+            std::move(cause));
+      }
+
+      if constexpr (std::is_void_v<value_type>) {
+        ev_.await_resume();
+        return await_result<value_type, cause_type>::from_value();
+      } else {
+        return await_result<value_type, cause_type>::from_value(
+            ev_.await_resume());
+      }
+    }
+
+  private:
+    /// Shared data of the process.
+    data &data_;
+
+    /// Awaited event.
+    Awaitable ev_;
+  };
+};
+} // namespace simcpp20
@@ -0,0 +1,741 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm>   // std::make_heap, std::move, std::nth_element, ...
+#include <array>       // std::array
+#include <bit>         // std::bit_width
+#include <cassert>     // assert
+#include <cmath>       // std::floor, std::fmod
+#include <cstddef>     // std::size_t
+#include <cstdint>     // std::uint64_t
+#include <functional>  // std::greater
+#include <iterator>    // std::back_inserter
+#include <type_traits> // std::conditional_t, std::is_integral_v
+#include <utility>     // std::move
+#include <vector>      // std::vector, std::erase_if
+
+namespace simcpp20 {
+/**
+ * Event queue backed by a binary heap.
+ *
+ * All event queues order their items using operator>, where a > b means that b
+ * must be processed before a. Items scheduled at the same time are thus
+ * processed in insertion order, as long as the item comparison takes the
+ * insertion ID into account.
+ *
+ * @tparam Item Type of the queued items.
+ */
+template <typename Item> class binary_heap {
+public:
+  /// @param item Item to insert.
+  void push(Item item) {
+    items_.push_back(std::move(item));
+    std::push_heap(items_.begin(), items_.end(), std::greater<Item>{});
+  }
+
+  /**
+   * Insert multiple items. If the batch is at least as large as the queue,
+   * the heap is rebuilt in linear time instead of inserting each item.
+   *
+   * @param items Items to insert.
+   */
+  void push_batch(std::vector<Item> items) {
+    if (items.size() < items_.size()) {
+      for (auto &item : items) {
+        push(std::move(item));
+      }
+      return;
+    }
+
+    items_.reserve(items_.size() + items.size());
+    std::move(items.begin(), items.end(), std::back_inserter(items_));
+    std::make_heap(items_.begin(), items_.end(), std::greater<Item>{});
+  }
+
+  /// @return Reference to the next item.
+  const Item &top() const {
+    assert(!empty());
+    return items_.front();
+  }
+
+  /// Remove the next item.
+  void pop() {
+    assert(!empty());
+    std::pop_heap(items_.begin(), items_.end(), std::greater<Item>{});
+    items_.pop_back();
+  }
+
+  /**
+   * Remove all items satisfying a predicate and rebuild the heap in linear
+   * time.
+   *
+   * @tparam Predicate Type of the predicate.
+   * @param pred Predicate returning whether to remove an item.
+   * @return Number of removed items.
+   */
+  template <typename Predicate> std::size_t remove_if(Predicate pred) {
+    auto n = static_cast<std::size_t>(std::erase_if(items_, pred));
+    std::make_heap(items_.begin(), items_.end(), std::greater<Item>{});
+    return n;
+  }
+
+  /// @return Whether the queue is empty.
+  bool empty() const { return items_.empty(); }
+
+  /// @return Number of items in the queue.
+  std::size_t size() const { return items_.size(); }
+
+private:
+  /// Queued items in heap order.
+  std::vector<Item> items_{};
+};
+
+/**
+ * Event queue backed by an implicit d-ary heap.
+ *
+ * Compared to a binary heap, the tree is shallower and the children of a node
+ * are adjacent in memory, so a sift-down touches fewer cache lines.
+ *
+ * @tparam Item Type of the queued items.
+ * @tparam Arity Number of children per node.
+ */
+template <typename Item, std::size_t Arity = 4> class d_ary_heap {
+  static_assert(Arity >= 2, "d_ary_heap requires an arity of at least 2");
+
+public:
+  /// @param item Item to insert.
+  void push(Item item) {
+    items_.push_back(std::move(item));
+    sift_up(items_.size() - 1);
+  }
+
+  /**
+   * Insert multiple items. If the batch is at least as large as the queue,
+   * the heap is rebuilt in linear time instead of inserting each item.
+   *
+   * @param items Items to insert.
+   */
+  void push_batch(std::vector<Item> items) {
+    if (items.size() < items_.size()) {
+      for (auto &item : items) {
+        push(std::move(item));
+      }
+      return;
+    }
+
+    items_.reserve(items_.size() + items.size());
+    std::move(items.begin(), items.end(), std::back_inserter(items_));
+    heapify();
+  }
+
+  /// @return Reference to the next item.
+  const Item &top() const {
+    assert(!empty());
+    return items_.front();
+  }
+
+  /// Remove the next item.
+  void pop() {
+    assert(!empty());
+
+    if (items_.size() > 1) {
+      items_.front() = std::move(items_.back());
+      items_.pop_back();
+      sift_down(0);
+    } else {
+      items_.pop_back();
+    }
+  }
+
+  /**
+   * Remove all items satisfying a predicate and rebuild the heap in linear
+   * time.
+   *
+   * @tparam Predicate Type of the predicate.
+   * @param pred Predicate returning whether to remove an item.
+   * @return Number of removed items.
+   */
+  template <typename Predicate> std::size_t remove_if(Predicate pred) {
+    auto n = static_cast<std::size_t>(std::erase_if(items_, pred));
+    heapify();
+    return n;
+  }
+
+  /// @return Whether the queue is empty.
+  bool empty() const { return items_.empty(); }
+
+  /// @return Number of items in the queue.
+  std::size_t size() const { return items_.size(); }
+
+private:
+  /// Restore the heap order of all items in linear time.
+  void heapify() {
+    if (items_.size() < 2) {
+      return;
+    }
+
+    // sift down all inner nodes, starting with the last one
+    for (std::size_t i = (items_.size() - 2) / Arity + 1; i-- > 0;) {
+      sift_down(i);
+    }
+  }
+
+  /// @param i Index of the item to move towards the root.
+  void sift_up(std::size_t i) {
+    Item item = std::move(items_[i]);
+
+    while (i > 0) {
+      std::size_t parent = (i - 1) / Arity;
+      if (!(items_[parent] > item)) {
+        break;
+      }
+
+      items_[i] = std::move(items_[parent]);
+      i = parent;
+    }
+
+    items_[i] = std::move(item);
+  }
+
+  /// @param i Index of the item to move towards the leaves.
+  void sift_down(std::size_t i) {
+    std::size_t n = items_.size();
+    Item item = std::move(items_[i]);
+
+    while (true) {
+      std::size_t first = i * Arity + 1;
+      if (first >= n) {
+        break;
+      }
+
+      std::size_t last = first + Arity < n ? first + Arity : n;
+      std::size_t min = first;
+      for (std::size_t child = first + 1; child < last; ++child) {
+        if (items_[min] > items_[child]) {
+          min = child;
+        }
+      }
+
+      if (!(item > items_[min])) {
+        break;
+      }
+
+      items_[i] = std::move(items_[min]);
+      i = min;
+    }
+
+    items_[i] = std::move(item);
+  }
+
+  /// Queued items in heap order.
+  std::vector<Item> items_{};
+};
+
+/**
+ * Event queue backed by a calendar queue (R. Brown, 1988).
+ *
+ * Items are hashed by time into buckets of a fixed width, such that one sweep
+ * over all buckets covers one "year". The number of buckets and their width
+ * are adapted to the number of items and their time distribution, so push and
+ * pop take amortized constant time for roughly uniform time distributions.
+ *
+ * The item time is read from the member time_ and must be convertible to
+ * double.
+ *
+ * @tparam Item Type of the queued items.
+ */
+template <typename Item> class calendar_queue {
+public:
+  /// Constructor.
+  calendar_queue() { buckets_.resize(min_buckets); }
+
+  /// @param item Item to insert.
+  void push(Item item) {
+    double day = day_of(item);
+    if (size_ == 0 || day < day_) {
+      // the sweep may have advanced past the day of the new item
+      day_ = day;
+      bucket_ = bucket_of(day);
+    }
+
+    insert(std::move(item), day);
+    ++size_;
+    top_valid_ = false;
+
+    if (size_ > 2 * buckets_.size()) {
+      resize(2 * buckets_.size());
+    }
+  }
+
+  /// @return Reference to the next item.
+  const Item &top() const {
+    assert(!empty());
+    locate();
+    return buckets_[bucket_].back();
+  }
+
+  /// Remove the next item.
+  void pop() {
+    assert(!empty());
+    locate();
+    buckets_[bucket_].pop_back();
+    --size_;
+    top_valid_ = false;
+
+    if (buckets_.size() > min_buckets && size_ < buckets_.size() / 2) {
+      resize(buckets_.size() / 2);
+    }
+  }
+
+  /**
+   * Remove all items satisfying a predicate. The buckets stay sorted.
+   *
+   * @tparam Predicate Type of the predicate.
+   * @param pred Predicate returning whether to remove an item.
+   * @return Number of removed items.
+   */
+  template <typename Predicate> std::size_t remove_if(Predicate pred) {
+    std::size_t n = 0;
+    for (auto &bucket : buckets_) {
+      n += static_cast<std::size_t>(std::erase_if(bucket, pred));
+    }
+
+    size_ -= n;
+    top_valid_ = false;
+
+    std::size_t n_buckets = buckets_.size();
+    while (n_buckets > min_buckets && size_ < n_buckets / 2) {
+      n_buckets /= 2;
+    }
+
+    if (n_buckets != buckets_.size()) {
+      resize(n_buckets);
+    }
+
+    return n;
+  }
+
+  /// @return Whether the queue is empty.
+  bool empty() const { return size_ == 0; }
+
+  /// @return Number of items in the queue.
+  std::size_t size() const { return size_; }
+
+private:
+  /// Minimum number of buckets. Must be a power of two.
+  static constexpr std::size_t min_buckets = 2;
+
+  /// Number of smallest items used to estimate the bucket width.
+  static constexpr std::size_t width_samples = 25;
+
+  /**
+   * @param item Item.
+   * @return Index of the day (bucket-sized interval since time 0) of the item.
+   */
+  double day_of(const Item &item) const {
+    return std::floor(static_cast<double>(item.time_) / width_);
+  }
+
+  /**
+   * @param day Index of a day.
+   * @return Index of the bucket holding the items of the given day.
+   */
+  std::size_t bucket_of(double day) const {
+    // buckets_.size() is a power of two
+    std::size_t mask = buckets_.size() - 1;
+    if (day < 9007199254740992.0) { // 2^53
+      return static_cast<std::size_t>(static_cast<std::uint64_t>(day) & mask);
+    }
+
+    return static_cast<std::size_t>(
+        std::fmod(day, static_cast<double>(buckets_.size())));
+  }
+
+  /**
+   * Insert an item into its bucket. Each bucket is sorted in descending order,
+   * so the next item of a bucket is its last element.
+   *
+   * @param item Item to insert.
+   * @param day Index of the day of the item.
+   */
+  void insert(Item item, double day) {
+    auto &bucket = buckets_[bucket_of(day)];
+    auto it = std::upper_bound(bucket.begin(), bucket.end(), item,
+                               std::greater<Item>{});
+    bucket.insert(it, std::move(item));
+  }
+
+  /**
+   * Locate the next item and advance the sweep to its bucket. Does nothing if
+   * the location is already known.
+   */
+  void locate() const {
+    if (top_valid_) {
+      return;
+    }
+
+    std::size_t mask = buckets_.size() - 1;
+
+    // sweep over one year, starting at the current day
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+      const auto &bucket = buckets_[bucket_];
+      if (!bucket.empty() && day_of(bucket.back()) == day_) {
+        top_valid_ = true;
+        return;
+      }
+
+      bucket_ = (bucket_ + 1) & mask;
+      day_ += 1;
+    }
+
+    // no item in the current year, search directly for the next item
+    const Item *next = nullptr;
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+      const auto &bucket = buckets_[i];
+      if (!bucket.empty() && (next == nullptr || *next > bucket.back())) {
+        next = &bucket.back();
+        bucket_ = i;
+      }
+    }
+
+    assert(next != nullptr);
+    day_ = day_of(*next);
+    top_valid_ = true;
+  }
+
+  /**
+   * Change the number of buckets and estimate a new bucket width from the
+   * spacing of the next items.
+   *
+   * @param n_buckets New number of buckets. Must be a power of two.
+   */
+  void resize(std::size_t n_buckets) {
+    std::vector<Item> items;
+    items.reserve(size_);
+    for (auto &bucket : buckets_) {
+      for (auto &item : bucket) {
+        items.push_back(std::move(item));
+      }
+    }
+
+    width_ = estimate_width(items);
+
+    buckets_.clear();
+    buckets_.resize(n_buckets);
+    top_valid_ = false;
+
+    bool first = true;
+    for (auto &item : items) {
+      double day = day_of(item);
+      if (first || day < day_) {
+        day_ = day;
+        first = false;
+      }
+
+      insert(std::move(item), day);
+    }
+
+    bucket_ = bucket_of(day_);
+  }
+
+  /**
+   * @param items All queued items. The order of the items is changed.
+   * @return Estimated bucket width.
+   */
+  double estimate_width(std::vector<Item> &items) const {
+    std::size_t n = items.size() < width_samples ? items.size() : width_samples;
+    if (n < 2) {
+      return width_;
+    }
+
+    auto less = [](const Item &a, const Item &b) { return b > a; };
+    std::nth_element(items.begin(), items.begin() + (n - 1), items.end(), less);
+    std::sort(items.begin(), items.begin() + n, less);
+
+    auto time = [&](std::size_t i) {
+      return static_cast<double>(items[i].time_);
+    };
+
+    double average = (time(n - 1) - time(0)) / static_cast<double>(n - 1);
+
+    // ignore large gaps, which would otherwise dominate the estimate
+    double sum = 0;
+    std::size_t count = 0;
+    for (std::size_t i = 1; i < n; ++i) {
+      double gap = time(i) - time(i - 1);
+      if (gap <= 2 * average) {
+        sum += gap;
+        ++count;
+      }
+    }
+
+    double width = count > 0 ? 3 * sum / static_cast<double>(count) : 0;
+    return width > 0 ? width : width_;
+  }
+
+  /// Buckets, each sorted in descending order.
+  std::vector<std::vector<Item>> buckets_{};
+
+  /// Width of one bucket.
+  double width_ = 1;
+
+  /// Number of queued items.
+  std::size_t size_ = 0;
+
+  /// Index of the bucket for the current day of the sweep.
+  mutable std::size_t bucket_ = 0;
+
+  /// Index of the current day of the sweep.
+  mutable double day_ = 0;
+
+  /// Whether bucket_ holds the next item.
+  mutable bool top_valid_ = false;
+};
+
+/**
+ * Event queue backed by a radix heap (R. Ahuja et al., 1990).
+ *
+ * Only supports integral, non-negative times. Items are usually not pushed
+ * with a time before the time of the last removed item, since events are
+ * never scheduled in the past. If one is, for example because a simulation
+ * skipped an aborted event without advancing its clock, the heap is rebuilt
+ * around the new item in linear time.
+ *
+ * Items are kept in buckets by the highest bit in which their time differs
+ * from the time of the last removed item. Bucket 0 holds the items at that
+ * time and is sorted. Once it is empty, the smallest time of the next
+ * non-empty bucket becomes the new reference time and the items of that
+ * bucket are distributed to lower buckets. Each item moves down at most once
+ * per bit, so push and pop take amortized constant time without comparing
+ * times of items in different buckets.
+ *
+ * The item time is read from the member time_ and must be integral.
+ *
+ * @tparam Item Type of the queued items.
+ */
+template <typename Item> class radix_heap {
+  static_assert(std::is_integral_v<decltype(Item::time_)>,
+                "radix_heap requires an integral time");
+
+public:
+  /// @param item Item to insert.
+  void push(Item item) {
+    if (key_of(item) < last_) {
+      rebase(key_of(item));
+    }
+
+    auto b = bucket_of(key_of(item));
+    if (b == 0) {
+      insert(std::move(item));
+      ++size_;
+      return;
+    }
+
+    auto &bucket = buckets_[b];
+    bucket.push_back(std::move(item));
+    ++size_;
+
+    if (top_valid_ && b < top_bucket_) {
+      top_valid_ = false;
+    } else if (top_valid_ && b == top_bucket_ &&
+               bucket[top_index_] > bucket.back()) {
+      top_index_ = bucket.size() - 1;
+    }
+  }
+
+  /// @return Reference to the next item.
+  const Item &top() const {
+    assert(!empty());
+    if (!buckets_[0].empty()) {
+      return buckets_[0].back();
+    }
+
+    locate();
+    return buckets_[top_bucket_][top_index_];
+  }
+
+  /// Remove the next item.
+  void pop() {
+    assert(!empty());
+    if (buckets_[0].empty()) {
+      refill();
+    }
+
+    buckets_[0].pop_back();
+    --size_;
+  }
+
+  /**
+   * Remove all items satisfying a predicate. Bucket 0 stays sorted.
+   *
+   * @tparam Predicate Type of the predicate.
+   * @param pred Predicate returning whether to remove an item.
+   * @return Number of removed items.
+   */
+  template <typename Predicate> std::size_t remove_if(Predicate pred) {
+    std::size_t n = 0;
+    for (auto &bucket : buckets_) {
+      n += static_cast<std::size_t>(std::erase_if(bucket, pred));
+    }
+
+    size_ -= n;
+    top_valid_ = false;
+    return n;
+  }
+
+  /// @return Whether the queue is empty.
+  bool empty() const { return size_ == 0; }
+
+  /// @return Number of items in the queue.
+  std::size_t size() const { return size_; }
+
+private:
+  /**
+   * @param item Item.
+   * @return Time of the item as an unsigned key.
+   */
+  static std::uint64_t key_of(const Item &item) {
+    assert(item.time_ >= 0);
+    return static_cast<std::uint64_t>(item.time_);
+  }
+
+  /**
+   * @param key Key of an item. Must not be less than the reference time.
+   * @return Index of the bucket holding items with the given key.
+   */
+  std::size_t bucket_of(std::uint64_t key) const {
+    assert(key >= last_);
+    return static_cast<std::size_t>(std::bit_width(key ^ last_));
+  }
+
+  /**
+   * Insert an item into bucket 0, which is sorted in descending order, so the
+   * next item is its last element.
+   *
+   * @param item Item to insert.
+   */
+  void insert(Item item) {
+    auto &bucket = buckets_[0];
+    auto it = std::upper_bound(bucket.begin(), bucket.end(), item,
+                               std::greater<Item>{});
+    bucket.insert(it, std::move(item));
+  }
+
+  /**
+   * Locate the next item in the first non-empty bucket other than bucket 0.
+   * Does nothing if the location is already known. The reference time is not
+   * changed, since items before the next item may still be pushed.
+   */
+  void locate() const {
+    if (top_valid_) {
+      return;
+    }
+
+    std::size_t b = 1;
+    while (buckets_[b].empty()) {
+      ++b;
+    }
+
+    const auto &bucket = buckets_[b];
+    top_bucket_ = b;
+    top_index_ = 0;
+    for (std::size_t i = 1; i < bucket.size(); ++i) {
+      if (bucket[top_index_] > bucket[i]) {
+        top_index_ = i;
+      }
+    }
+
+    top_valid_ = true;
+  }
+
+  /**
+   * Advance the reference time to the next item, which is about to be
+   * removed, and distribute the items of its bucket. Bucket 0 must be empty.
+   */
+  void refill() {
+    locate();
+    auto &bucket = buckets_[top_bucket_];
+    last_ = key_of(bucket[top_index_]);
+    top_valid_ = false;
+
+    // all items move to lower buckets, since they share the bits above the
+    // bit of their bucket with the new reference time
+    for (auto &item : bucket) {
+      buckets_[bucket_of(key_of(item))].push_back(std::move(item));
+    }
+
+    bucket.clear();
+    std::sort(buckets_[0].begin(), buckets_[0].end(), std::greater<Item>{});
+  }
+
+  /**
+   * Lower the reference time and distribute all items again.
+   *
+   * @param key New reference time. Must be less than the current one.
+   */
+  void rebase(std::uint64_t key) {
+    std::vector<Item> items;
+    items.reserve(size_);
+    for (auto &bucket : buckets_) {
+      for (auto &item : bucket) {
+        items.push_back(std::move(item));
+      }
+
+      bucket.clear();
+    }
+
+    last_ = key;
+    top_valid_ = false;
+    for (auto &item : items) {
+      buckets_[bucket_of(key_of(item))].push_back(std::move(item));
+    }
+
+    std::sort(buckets_[0].begin(), buckets_[0].end(), std::greater<Item>{});
+  }
+
+  /**
+   * Buckets. The highest bit in which the key of an item in bucket i > 0
+   * differs from last_ is bit i - 1.
+   */
+  std::array<std::vector<Item>, 65> buckets_{};
+
+  /**
+   * Reference time, which is the time of the last removed item, or of an
+   * earlier item pushed since.
+   */
+  std::uint64_t last_ = 0;
+
+  /// Number of queued items.
+  std::size_t size_ = 0;
+
+  /// Bucket of the next item, if bucket 0 is empty.
+  mutable std::size_t top_bucket_ = 0;
+
+  /// Index of the next item in its bucket, if bucket 0 is empty.
+  mutable std::size_t top_index_ = 0;
+
+  /// Whether top_bucket_ and top_index_ locate the next item.
+  mutable bool top_valid_ = false;
+};
+
+namespace detail {
+/// Whether an item has an integral member time_.
+template <typename Item>
+concept integral_time = requires {
+  requires std::is_integral_v<decltype(Item::time_)>;
+};
+} // namespace detail
+
+/**
+ * Event queue used by default: a radix heap for integral times and a binary
+ * heap otherwise.
+ *
+ * @tparam Item Type of the queued items.
+ */
+template <typename Item>
+using default_queue =
+    std::conditional_t<detail::integral_time<Item>, radix_heap<Item>,
+                       binary_heap<Item>>;
+} // namespace simcpp20
@@ -0,0 +1,380 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <array>   // std::array
+#include <cassert> // assert
+#include <cmath>   // std::log, std::sqrt, std::cos, std::sin, std::exp
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t, std::uint64_t
+#include <limits>  // std::numeric_limits
+#include <span>    // std::span
+#include <utility> // std::move
+
+namespace simcpp20 {
+/**
+ * Counter-based random number generator Philox4x32-10 (J. Salmon et al.,
+ * 2011).
+ *
+ * Each output block is a bijective function of a 128-bit counter and a 64-bit
+ * key, so blocks are computed independently of each other. The key is the
+ * seed, and the upper half of the counter is the stream, which gives 2^64
+ * independent streams of 2^66 numbers per seed without any state besides the
+ * position.
+ */
+class philox {
+public:
+  /// Four 32-bit numbers, the output of one counter.
+  using block = std::array<std::uint32_t, 4>;
+
+  /**
+   * @param counter Counter.
+   * @param key Key.
+   * @return Output block for the given counter and key.
+   */
+  static constexpr block generate(block counter,
+                                  std::array<std::uint32_t, 2> key) {
+    for (int round = 0; round < 10; ++round) {
+      auto p0 = static_cast<std::uint64_t>(m0) * counter[0];
+      auto p1 = static_cast<std::uint64_t>(m1) * counter[2];
+      counter = {static_cast<std::uint32_t>(p1 >> 32) ^ counter[1] ^ key[0],
+                 static_cast<std::uint32_t>(p1),
+                 static_cast<std::uint32_t>(p0 >> 32) ^ counter[3] ^ key[1],
+                 static_cast<std::uint32_t>(p0)};
+      key[0] += w0;
+      key[1] += w1;
+    }
+
+    return counter;
+  }
+
+  /**
+   * Compute the output blocks of multiple counters at once. The counters are
+   * stored as four arrays of their words, so the rounds are vectorized by the
+   * compiler. The outputs replace the counters.
+   *
+   * @tparam N Size of the arrays.
+   * @param words Words of the counters.
+   * @param n Number of counters, at most N.
+   * @param key Key.
+   */
+  template <std::size_t N>
+  static void generate_n(std::array<std::array<std::uint32_t, N>, 4> &words,
+                         std::size_t n, std::array<std::uint32_t, 2> key) {
+    auto &[c0, c1, c2, c3] = words;
+    for (int round = 0; round < 10; ++round) {
+      for (std::size_t j = 0; j < n; ++j) {
+        auto p0 = static_cast<std::uint64_t>(m0) * c0[j];
+        auto p1 = static_cast<std::uint64_t>(m1) * c2[j];
+        c0[j] = static_cast<std::uint32_t>(p1 >> 32) ^ c1[j] ^ key[0];
+        c1[j] = static_cast<std::uint32_t>(p1);
+        c2[j] = static_cast<std::uint32_t>(p0 >> 32) ^ c3[j] ^ key[1];
+        c3[j] = static_cast<std::uint32_t>(p0);
+      }
+
+      key[0] += w0;
+      key[1] += w1;
+    }
+  }
+
+private:
+  /// Multipliers of the rounds.
+  static constexpr std::uint32_t m0 = 0xD2511F53;
+  static constexpr std::uint32_t m1 = 0xCD9E8D57;
+
+  /// Increments of the key between rounds.
+  static constexpr std::uint32_t w0 = 0x9E3779B9;
+  static constexpr std::uint32_t w1 = 0xBB67AE85;
+};
+
+/**
+ * Reproducible stream of random numbers, identified by a seed and a stream
+ * ID. Streams with different IDs are independent, so each process or entity
+ * of a model and each replication can use its own stream:
+ *
+ *     simcpp20::random_stream rng{seed, customer_id};
+ *     std::exponential_distribution<> dist{1. / 12};
+ *     double service_time = dist(rng);
+ *
+ * The stream can be used as a uniform random bit generator with the
+ * distributions of the standard library. Filling spans with variates of the
+ * common distributions is much cheaper, since the loops over independent
+ * counters are vectorized by the compiler. See also buffered_variates.
+ */
+class random_stream {
+public:
+  /// Type of the generated numbers.
+  using result_type = std::uint32_t;
+
+  /**
+   * Constructor.
+   *
+   * @param seed Seed, for example of a replication.
+   * @param stream ID of the stream.
+   */
+  explicit random_stream(std::uint64_t seed, std::uint64_t stream = 0)
+      : key_{static_cast<std::uint32_t>(seed),
+             static_cast<std::uint32_t>(seed >> 32)},
+        stream_{stream} {}
+
+  /// @return Smallest generated number.
+  static constexpr result_type min() { return 0; }
+
+  /// @return Largest generated number.
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  /// @return Next uniformly distributed 32-bit number.
+  result_type operator()() {
+    if (n_buffered_ == 0) {
+      buffer_ = next_block();
+      n_buffered_ = buffer_.size();
+    }
+
+    return buffer_[buffer_.size() - n_buffered_--];
+  }
+
+  /**
+   * Fill a span with uniformly distributed numbers in [a, b).
+   *
+   * @param out Span to fill.
+   * @param a Lower bound.
+   * @param b Upper bound.
+   */
+  void fill_uniform(std::span<double> out, double a = 0, double b = 1) {
+    fill_units(out);
+    for (auto &x : out) {
+      x = a + (b - a) * x;
+    }
+  }
+
+  /**
+   * Fill a span with exponentially distributed numbers.
+   *
+   * @param out Span to fill.
+   * @param rate Rate of the distribution. Must be positive.
+   */
+  void fill_exponential(std::span<double> out, double rate) {
+    assert(rate > 0);
+    fill_units(out);
+    for (auto &x : out) {
+      // 1 - x is in (0, 1], so the logarithm is finite
+      x = -std::log(1 - x) / rate;
+    }
+  }
+
+  /**
+   * Fill a span with normally distributed numbers using the Box-Muller
+   * transform.
+   *
+   * @param out Span to fill.
+   * @param mean Mean of the distribution.
+   * @param stddev Standard deviation of the distribution.
+   */
+  void fill_normal(std::span<double> out, double mean = 0, double stddev = 1) {
+    constexpr double two_pi = 6.283185307179586;
+
+    // each pair of uniform numbers gives two normal numbers
+    std::array<double, 2 * chunk> units;
+    for (std::size_t i = 0; i < out.size(); i += 2 * chunk) {
+      std::size_t n = out.size() - i < 2 * chunk ? out.size() - i : 2 * chunk;
+      std::size_t n_pairs = (n + 1) / 2;
+      fill_units({units.data(), 2 * n_pairs});
+
+      std::array<double, 2 * chunk> normals;
+      for (std::size_t j = 0; j < n_pairs; ++j) {
+        double r = std::sqrt(-2 * std::log(1 - units[2 * j]));
+        double theta = two_pi * units[2 * j + 1];
+        normals[2 * j] = r * std::cos(theta);
+        normals[2 * j + 1] = r * std::sin(theta);
+      }
+
+      for (std::size_t j = 0; j < n; ++j) {
+        out[i + j] = mean + stddev * normals[j];
+      }
+    }
+  }
+
+  /**
+   * Fill a span with log-normally distributed numbers.
+   *
+   * @param out Span to fill.
+   * @param m Mean of the underlying normal distribution.
+   * @param s Standard deviation of the underlying normal distribution.
+   */
+  void fill_lognormal(std::span<double> out, double m = 0, double s = 1) {
+    fill_normal(out, m, s);
+    for (auto &x : out) {
+      x = std::exp(x);
+    }
+  }
+
+private:
+  /// Number of counters processed at once when filling spans.
+  static constexpr std::size_t chunk = 64;
+
+  /// @return Output block of the next counter.
+  philox::block next_block() {
+    philox::block counter{static_cast<std::uint32_t>(position_),
+                          static_cast<std::uint32_t>(position_ >> 32),
+                          static_cast<std::uint32_t>(stream_),
+                          static_cast<std::uint32_t>(stream_ >> 32)};
+    ++position_;
+    return philox::generate(counter, key_);
+  }
+
+  /**
+   * Fill a span with uniformly distributed numbers in [0, 1) with 53 random
+   * bits each. Each counter gives two numbers.
+   *
+   * @param out Span to fill.
+   */
+  void fill_units(std::span<double> out) {
+    constexpr double scale = 1.0 / 9007199254740992.0; // 2^-53
+
+    std::array<std::array<std::uint32_t, chunk>, 4> words;
+    for (std::size_t i = 0; i < out.size(); i += 2 * chunk) {
+      std::size_t n = out.size() - i < 2 * chunk ? out.size() - i : 2 * chunk;
+      std::size_t n_blocks = (n + 1) / 2;
+
+      for (std::size_t j = 0; j < n_blocks; ++j) {
+        auto position = position_ + j;
+        words[0][j] = static_cast<std::uint32_t>(position);
+        words[1][j] = static_cast<std::uint32_t>(position >> 32);
+        words[2][j] = static_cast<std::uint32_t>(stream_);
+        words[3][j] = static_cast<std::uint32_t>(stream_ >> 32);
+      }
+
+      philox::generate_n(words, n_blocks, key_);
+      position_ += n_blocks;
+
+      // the first and last two words of a block give one number each
+      for (std::size_t j = 0; j < n; ++j) {
+        auto hi = static_cast<std::uint64_t>(words[2 * (j % 2)][j / 2]);
+        auto lo = static_cast<std::uint64_t>(words[2 * (j % 2) + 1][j / 2]);
+        out[i + j] = static_cast<double>((hi << 21) ^ (lo >> 11)) * scale;
+      }
+    }
+  }
+
+  /// Key, which is the seed.
+  std::array<std::uint32_t, 2> key_;
+
+  /// ID of the stream, the upper half of the counter.
+  std::uint64_t stream_;
+
+  /// Position in the stream, the lower half of the counter.
+  std::uint64_t position_ = 0;
+
+  /// Output block of the last counter used by operator().
+  philox::block buffer_{};
+
+  /// Number of numbers in buffer_ not returned yet.
+  std::size_t n_buffered_ = 0;
+};
+
+/**
+ * Variates of one distribution, drawn from a random stream in blocks and
+ * returned one at a time. Useful for processes drawing one variate per step,
+ * for example a service time per customer:
+ *
+ *     simcpp20::random_stream rng{seed, id};
+ *     auto service_time = simcpp20::exponential_variates(rng, 1. / 12);
+ *     co_await sim.timeout(service_time());
+ *
+ * @tparam Fill Type of the function filling a block. Must be callable with a
+ * reference to the random stream and a std::span<double>.
+ * @tparam BlockSize Number of variates drawn at once.
+ */
+template <typename Fill, std::size_t BlockSize = 256> class buffered_variates {
+public:
+  /**
+   * Constructor.
+   *
+   * @param stream Reference to the random stream. Must be valid as long as
+   * the buffered variates are used.
+   * @param fill Function filling a block with variates.
+   */
+  buffered_variates(random_stream &stream, Fill fill)
+      : stream_{stream}, fill_{std::move(fill)} {}
+
+  /// @return Next variate.
+  double operator()() {
+    if (next_ == BlockSize) {
+      fill_(stream_, std::span<double>{block_});
+      next_ = 0;
+    }
+
+    return block_[next_++];
+  }
+
+private:
+  /// Reference to the random stream.
+  random_stream &stream_;
+
+  /// Function filling a block with variates.
+  Fill fill_;
+
+  /// Drawn variates.
+  std::array<double, BlockSize> block_{};
+
+  /// Index of the next variate in the block.
+  std::size_t next_ = BlockSize;
+};
+
+/**
+ * @param stream Reference to the random stream.
+ * @param a Lower bound.
+ * @param b Upper bound.
+ * @return Buffered uniformly distributed variates in [a, b).
+ */
+inline auto uniform_variates(random_stream &stream, double a = 0,
+                             double b = 1) {
+  return buffered_variates{stream,
+                           [a, b](random_stream &s, std::span<double> out) {
+                             s.fill_uniform(out, a, b);
+                           }};
+}
+
+/**
+ * @param stream Reference to the random stream.
+ * @param rate Rate of the distribution. Must be positive.
+ * @return Buffered exponentially distributed variates.
+ */
+inline auto exponential_variates(random_stream &stream, double rate) {
+  return buffered_variates{stream,
+                           [rate](random_stream &s, std::span<double> out) {
+                             s.fill_exponential(out, rate);
+                           }};
+}
+
+/**
+ * @param stream Reference to the random stream.
+ * @param mean Mean of the distribution.
+ * @param stddev Standard deviation of the distribution.
+ * @return Buffered normally distributed variates.
+ */
+inline auto normal_variates(random_stream &stream, double mean = 0,
+                            double stddev = 1) {
+  return buffered_variates{
+      stream, [mean, stddev](random_stream &s, std::span<double> out) {
+        s.fill_normal(out, mean, stddev);
+      }};
+}
+
+/**
+ * @param stream Reference to the random stream.
+ * @param m Mean of the underlying normal distribution.
+ * @param s Standard deviation of the underlying normal distribution.
+ * @return Buffered log-normally distributed variates.
+ */
+inline auto lognormal_variates(random_stream &stream, double m = 0,
+                               double s = 1) {
+  return buffered_variates{
+      stream, [m, s](random_stream &rs, std::span<double> out) {
+        rs.fill_lognormal(out, m, s);
+      }};
+}
+} // namespace simcpp20
@@ -0,0 +1,235 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm>   // std::max, std::min
+#include <atomic>      // std::atomic
+#include <cassert>     // assert
+#include <cstddef>     // std::ptrdiff_t, std::size_t
+#include <cstdint>     // std::uint64_t
+#include <exception>   // std::exception_ptr, std::rethrow_exception
+#include <functional>  // std::invoke
+#include <mutex>       // std::mutex, std::lock_guard
+#include <optional>    // std::optional
+#include <thread>      // std::thread
+#include <type_traits> // std::invoke_result_t, std::is_constructible_v
+#include <utility>     // std::move
+#include <vector>      // std::vector
+
+#include "monitor.hpp"
+#include "policy.hpp"
+#include "simulation.hpp"
+
+namespace simcpp20 {
+/**
+ * Run independent replications of a model in parallel.
+ *
+ * Each replication runs on a fresh simulation instance, which is only used by
+ * a single thread, so its event and frame pools are never shared. If the
+ * allocator of the policy supports borrowing memory, as pool_allocator does,
+ * each thread keeps one allocator whose memory the simulations of its
+ * replications borrow, so the pools are not refilled per replication. Threads
+ * claim the next replication from a shared counter once they finished their
+ * previous one, which balances replications with different run times.
+ *
+ * The results are ordered by replication and do not depend on the number of
+ * threads, as long as the model only depends on the simulation and the seed.
+ *
+ *     auto waits = simcpp20::replicate(
+ *         [](simcpp20::simulation<> &sim, std::uint64_t seed) {
+ *           // set up the model using seed, run sim, return the result
+ *         },
+ *         1000);
+ *
+ * If a replication throws an exception, no further replications are started
+ * and the first exception is rethrown once all threads finished.
+ *
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulations.
+ * @tparam Model Type of the model. Must be callable with a reference to a
+ * simulation and a seed.
+ * @param model Model, called once per replication. Called concurrently from
+ * multiple threads.
+ * @param n Number of replications.
+ * @param first_seed Seed of the first replication. Replication i uses seed
+ * first_seed + i.
+ * @param n_threads Number of threads. If 0, the number of hardware threads is
+ * used.
+ * @return Results of the model, one per replication.
+ */
+template <typename Time = double, typename Policy = default_policy,
+          typename Model>
+auto replicate(Model model, std::size_t n, std::uint64_t first_seed = 0,
+               std::size_t n_threads = 0) {
+  using result_type =
+      std::invoke_result_t<Model &, simulation<Time, Policy> &, std::uint64_t>;
+
+  std::vector<std::optional<result_type>> results(n);
+  std::atomic<std::size_t> next{0};
+  std::exception_ptr error = nullptr;
+  std::mutex error_mutex;
+
+  using allocator_type = typename Policy::allocator;
+  auto work = [&] {
+    [[maybe_unused]] allocator_type pool{};
+    while (true) {
+      std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+      if (i >= n) {
+        return;
+      }
+
+      try {
+        if constexpr (std::is_constructible_v<allocator_type,
+                                              allocator_type *>) {
+          simulation<Time, Policy> sim{&pool};
+          results[i].emplace(std::invoke(model, sim, first_seed + i));
+        } else {
+          simulation<Time, Policy> sim;
+          results[i].emplace(std::invoke(model, sim, first_seed + i));
+        }
+      } catch (...) {
+        std::lock_guard lock{error_mutex};
+        if (error == nullptr) {
+          error = std::current_exception();
+        }
+
+        // stop all threads after their current replication
+        next.store(n, std::memory_order_relaxed);
+        return;
+      }
+    }
+  };
+
+  if (n_threads == 0) {
+    n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  n_threads = std::min(n_threads, n);
+
+  // the calling thread runs replications as well
+  std::vector<std::thread> threads;
+  if (n_threads > 1) {
+    threads.reserve(n_threads - 1);
+    for (std::size_t i = 1; i < n_threads; ++i) {
+      threads.emplace_back(work);
+    }
+  }
+
+  work();
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+
+  std::vector<result_type> flat;
+  flat.reserve(n);
+  for (auto &result : results) {
+    flat.push_back(std::move(*result));
+  }
+
+  return flat;
+}
+
+/**
+ * Run independent replications of a model in parallel and reduce their
+ * results. See replicate.
+ *
+ * The results are reduced in the order of the replications on the calling
+ * thread, so floating-point sums do not depend on the number of threads.
+ *
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulations.
+ * @tparam Model Type of the model. Must be callable with a reference to a
+ * simulation and a seed.
+ * @tparam T Type of the reduced value.
+ * @tparam Reduce Type of the reduction. Must be callable with the reduced
+ * value so far and the result of one replication.
+ * @param model Model, called once per replication.
+ * @param n Number of replications.
+ * @param init Initial reduced value.
+ * @param reduce Reduction.
+ * @param first_seed Seed of the first replication.
+ * @param n_threads Number of threads. If 0, the number of hardware threads is
+ * used.
+ * @return Reduced value.
+ */
+template <typename Time = double, typename Policy = default_policy,
+          typename Model, typename T, typename Reduce>
+T replicate_reduce(Model model, std::size_t n, T init, Reduce reduce,
+                   std::uint64_t first_seed = 0, std::size_t n_threads = 0) {
+  auto results = replicate<Time, Policy>(std::move(model), n, first_seed,
+                                         n_threads);
+  for (auto &result : results) {
+    init = std::invoke(reduce, std::move(init), std::move(result));
+  }
+
+  return init;
+}
+
+/**
+ * Run independent replications of a model in parallel until the confidence
+ * interval of the mean of their results is precise enough. See replicate.
+ *
+ * Replications run in rounds of one replication per thread, after a first
+ * round of min_n replications. After each round, the results are checked in
+ * the order of the replications and the first number of replications for
+ * which the relative half-width is at most the target is kept. Later results
+ * are discarded, so the returned results do not depend on the number of
+ * threads.
+ *
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulations.
+ * @tparam Model Type of the model. Must be callable with a reference to a
+ * simulation and a seed and return a type convertible to double.
+ * @param model Model, called once per replication.
+ * @param target Target relative half-width, for example 0.05.
+ * @param confidence Confidence level of the half-width.
+ * @param min_n Minimum number of replications. Must be at least two.
+ * @param max_n Maximum number of replications.
+ * @param first_seed Seed of the first replication.
+ * @param n_threads Number of threads. If 0, the number of hardware threads is
+ * used.
+ * @return Results of the model, one per replication. Contains max_n results if
+ * the target was not reached.
+ */
+template <typename Time = double, typename Policy = default_policy,
+          typename Model>
+auto replicate_until(Model model, double target, double confidence = 0.95,
+                     std::size_t min_n = 10, std::size_t max_n = 1000,
+                     std::uint64_t first_seed = 0, std::size_t n_threads = 0) {
+  assert(min_n >= 2);
+
+  if (n_threads == 0) {
+    n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  auto results = replicate<Time, Policy>(model, std::min(min_n, max_n),
+                                         first_seed, n_threads);
+  tally stat;
+  for (std::size_t i = 0;; ++i) {
+    if (i == results.size()) {
+      if (i >= max_n) {
+        return results;
+      }
+
+      auto round = replicate<Time, Policy>(
+          model, std::min(n_threads, max_n - i), first_seed + i, n_threads);
+      for (auto &result : round) {
+        results.push_back(std::move(result));
+      }
+    }
+
+    stat.add(static_cast<double>(results[i]));
+    if (i + 1 >= min_n && stat.relative_half_width(confidence) <= target) {
+      // erase instead of resize, which requires a default constructor
+      results.erase(results.begin() + static_cast<std::ptrdiff_t>(i + 1),
+                    results.end());
+      return results;
+    }
+  }
+}
+} // namespace simcpp20
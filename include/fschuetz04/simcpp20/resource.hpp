@@ -0,0 +1,562 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <map>     // std::map
+#include <utility> // std::move
+#include <vector>  // std::vector
+
+#include "callback.hpp"
+#include "monitor.hpp"
+#include "process.hpp"
+#include "simulation.hpp"
+#include "waiter_heap.hpp"
+#include "waiter_list.hpp"
+
+namespace simcpp20 {
+/**
+ * Resource with a limited number of usage slots. Requests are granted in the
+ * order they are made.
+ *
+ * An aborted request is removed from the waiting requests immediately, for
+ * example when a customer reneges:
+ *
+ *     auto request = counters.request();
+ *     co_await (request | sim.timeout(max_wait_time));
+ *     if (!request.triggered()) {
+ *       request.abort();
+ *     }
+ *
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulation.
+ */
+template <typename Time = double, typename Policy = default_policy>
+class resource {
+public:
+  /// Event type.
+  using event_type = event<Time, Policy>;
+
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation.
+   * @param capacity Number of usage slots.
+   */
+  resource(simulation<Time, Policy> &sim, std::uint64_t capacity)
+      : sim_{sim}, waiters_{[this](auto &) { record(); }},
+        available_{capacity}, capacity_{capacity} {}
+
+  resource(const resource &) = delete;
+  resource &operator=(const resource &) = delete;
+
+  /**
+   * Request a usage slot. The slot must be released using release once the
+   * request is triggered, unless the request is aborted before.
+   *
+   * @return Pending event which is triggered once a slot is available.
+   */
+  event_type request() {
+    auto ev = sim_.event();
+    if (available_ > 0) {
+      --available_;
+      ev.trigger();
+    } else {
+      waiters_.push_back(ev);
+    }
+
+    record();
+    return ev;
+  }
+
+  /// Release a usage slot and grant the next waiting request, if any.
+  void release() {
+    assert(available_ < capacity_);
+
+    if (waiters_.empty()) {
+      ++available_;
+    } else {
+      waiters_.pop_front().trigger();
+    }
+
+    record();
+  }
+
+  /// @return Number of available usage slots.
+  std::uint64_t available() const { return available_; }
+
+  /// @return Number of usage slots.
+  std::uint64_t capacity() const { return capacity_; }
+
+  /// @return Number of waiting requests.
+  std::size_t queued() const { return waiters_.size(); }
+
+  /**
+   * Record the number of waiting requests and the number of used slots in
+   * time-weighted monitors from now on. Each update costs a few arithmetic
+   * operations.
+   *
+   * @param queued Monitor of the number of waiting requests, or nullptr.
+   * @param in_use Monitor of the number of used slots, or nullptr.
+   */
+  void monitor(time_weighted<Time, Policy> *queued,
+               time_weighted<Time, Policy> *in_use = nullptr) {
+    queued_monitor_ = queued;
+    in_use_monitor_ = in_use;
+    record();
+  }
+
+private:
+  /// Update the monitors, if any.
+  void record() {
+    if (queued_monitor_ != nullptr) {
+      queued_monitor_->set(static_cast<double>(queued()));
+    }
+
+    if (in_use_monitor_ != nullptr) {
+      in_use_monitor_->set(static_cast<double>(capacity_ - available_));
+    }
+  }
+
+  /// Reference to the simulation.
+  simulation<Time, Policy> &sim_;
+
+  /// Waiting requests.
+  detail::waiter_list<event_type> waiters_;
+
+  /// Number of available usage slots.
+  std::uint64_t available_;
+
+  /// Number of usage slots.
+  std::uint64_t capacity_;
+
+  /// Monitor of the number of waiting requests, or nullptr.
+  time_weighted<Time, Policy> *queued_monitor_ = nullptr;
+
+  /// Monitor of the number of used slots, or nullptr.
+  time_weighted<Time, Policy> *in_use_monitor_ = nullptr;
+};
+
+/**
+ * Resource with a limited number of usage slots. Requests with a smaller
+ * priority value are granted first. Requests with the same priority are
+ * granted in the order they are made.
+ *
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulation.
+ */
+template <typename Time = double, typename Policy = default_policy>
+class priority_resource {
+public:
+  /// Event type.
+  using event_type = event<Time, Policy>;
+
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation.
+   * @param capacity Number of usage slots.
+   */
+  priority_resource(simulation<Time, Policy> &sim, std::uint64_t capacity)
+      : sim_{sim}, available_{capacity}, capacity_{capacity} {}
+
+  priority_resource(const priority_resource &) = delete;
+  priority_resource &operator=(const priority_resource &) = delete;
+
+  /**
+   * Request a usage slot. The slot must be released using release once the
+   * request is triggered, unless the request is aborted before.
+   *
+   * @param priority Priority of the request. Smaller values are granted first.
+   * @return Pending event which is triggered once a slot is available.
+   */
+  event_type request(int priority = 0) {
+    auto ev = sim_.event();
+    if (available_ > 0) {
+      --available_;
+      ev.trigger();
+      record();
+      return ev;
+    }
+
+    auto on_cancel = [this](auto &) {
+      --queued_;
+      record();
+    };
+    waiters_.try_emplace(priority, on_cancel).first->second.push_back(ev);
+    ++queued_;
+
+    record();
+    return ev;
+  }
+
+  /// Release a usage slot and grant the next waiting request, if any.
+  void release() {
+    assert(available_ < capacity_);
+
+    // lists emptied by aborted requests are only removed here
+    while (!waiters_.empty() && waiters_.begin()->second.empty()) {
+      waiters_.erase(waiters_.begin());
+    }
+
+    if (waiters_.empty()) {
+      ++available_;
+    } else {
+      --queued_;
+      waiters_.begin()->second.pop_front().trigger();
+    }
+
+    record();
+  }
+
+  /// @return Number of available usage slots.
+  std::uint64_t available() const { return available_; }
+
+  /// @return Number of usage slots.
+  std::uint64_t capacity() const { return capacity_; }
+
+  /// @return Number of waiting requests.
+  std::size_t queued() const { return queued_; }
+
+  /**
+   * Record the number of waiting requests and the number of used slots in
+   * time-weighted monitors from now on. Each update costs a few arithmetic
+   * operations.
+   *
+   * @param queued Monitor of the number of waiting requests, or nullptr.
+   * @param in_use Monitor of the number of used slots, or nullptr.
+   */
+  void monitor(time_weighted<Time, Policy> *queued,
+               time_weighted<Time, Policy> *in_use = nullptr) {
+    queued_monitor_ = queued;
+    in_use_monitor_ = in_use;
+    record();
+  }
+
+private:
+  /// Update the monitors, if any.
+  void record() {
+    if (queued_monitor_ != nullptr) {
+      queued_monitor_->set(static_cast<double>(queued()));
+    }
+
+    if (in_use_monitor_ != nullptr) {
+      in_use_monitor_->set(static_cast<double>(capacity_ - available_));
+    }
+  }
+
+  /// Reference to the simulation.
+  simulation<Time, Policy> &sim_;
+
+  /**
+   * Waiting requests, one list per priority. Lists are stable in memory, since
+   * the entries link back to their list.
+   */
+  std::map<int, detail::waiter_list<event_type>> waiters_{};
+
+  /// Number of waiting requests.
+  std::size_t queued_ = 0;
+
+  /// Number of available usage slots.
+  std::uint64_t available_;
+
+  /// Number of usage slots.
+  std::uint64_t capacity_;
+
+  /// Monitor of the number of waiting requests, or nullptr.
+  time_weighted<Time, Policy> *queued_monitor_ = nullptr;
+
+  /// Monitor of the number of used slots, or nullptr.
+  time_weighted<Time, Policy> *in_use_monitor_ = nullptr;
+};
+
+/**
+ * Resource with a limited number of usage slots, where requests with a smaller
+ * priority value can preempt users with a larger priority value. If all slots
+ * are used, a preempting request replaces the user with the largest priority
+ * value, or the most recent of them. The preempted user is notified using the
+ * callback passed with its request, or interrupted if it passed its process.
+ * Waiting requests are granted by priority, and in the order they are made for
+ * the same priority.
+ *
+ * Waiting requests are kept in an indexed heap, so aborting a request and
+ * changing its priority take logarithmic time.
+ *
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulation.
+ */
+template <typename Time = double, typename Policy = default_policy>
+class preemptive_resource {
+public:
+  /// Event type.
+  using event_type = event<Time, Policy>;
+
+  /// Cause passed to a preempted user.
+  struct preemption {
+    /// Request which preempted the user.
+    event_type by_;
+
+    /// Time at which the preempted user was granted its usage slot.
+    Time usage_since_;
+  };
+
+  /// Callback called when a user is preempted.
+  using preempted_callback = detail::callback<const preemption &>;
+
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation.
+   * @param capacity Number of usage slots.
+   */
+  preemptive_resource(simulation<Time, Policy> &sim, std::uint64_t capacity)
+      : sim_{sim}, waiters_{[this](auto &) { record(); }},
+        capacity_{capacity} {
+    users_.reserve(capacity);
+  }
+
+  preemptive_resource(const preemptive_resource &) = delete;
+  preemptive_resource &operator=(const preemptive_resource &) = delete;
+
+  /**
+   * Request a usage slot. The slot must be released using release once the
+   * request is triggered, unless the request is aborted or preempted before.
+   *
+   * @param priority Priority of the request. Smaller values are granted first.
+   * @param preempt Whether the request may preempt a user if all usage slots
+   * are used.
+   * @param on_preempted Callback to be called if the usage slot granted to
+   * this request is preempted.
+   * @return Pending event which is triggered once a slot is available.
+   */
+  event_type request(int priority = 0, bool preempt = true,
+                     preempted_callback on_preempted = ignore) {
+    auto ev = sim_.event();
+    key k{priority, next_id_};
+    ++next_id_;
+
+    if (users_.size() < capacity_) {
+      grant(ev, k, std::move(on_preempted));
+      record();
+      return ev;
+    }
+
+    if (preempt && !users_.empty()) {
+      auto victim = users_.begin();
+      for (auto it = users_.begin(); it != users_.end(); ++it) {
+        if (victim->key_ < it->key_) {
+          victim = it;
+        }
+      }
+
+      if (k < victim->key_) {
+        user preempted = std::move(*victim);
+        remove_user(victim);
+
+        grant(ev, k, std::move(on_preempted));
+        preempted.on_preempted_(preemption{ev, preempted.usage_since_});
+        return ev;
+      }
+    }
+
+    waiters_.push(ev, waiting{k, std::move(on_preempted)});
+    record();
+    return ev;
+  }
+
+  /**
+   * Request a usage slot for a process. If the usage slot is preempted, the
+   * process is interrupted with the preemption as cause.
+   *
+   * @param proc Process using the slot.
+   * @param priority Priority of the request. Smaller values are granted first.
+   * @param preempt Whether the request may preempt a user if all usage slots
+   * are used.
+   * @return Pending event which is triggered once a slot is available.
+   */
+  event_type request(const process<Time, Policy> &proc, int priority = 0,
+                     bool preempt = true) {
+    return request(priority, preempt,
+                   [proc](const preemption &p) { proc.interrupt(p); });
+  }
+
+  /**
+   * Release the usage slot granted to a request and grant the next waiting
+   * request, if any. Does nothing if the request does not use a slot, for
+   * example because it was preempted.
+   *
+   * @param request Request passed to the user.
+   */
+  void release(const event_type &request) {
+    auto it = users_.begin();
+    while (it != users_.end() && !(it->request_ == request)) {
+      ++it;
+    }
+
+    if (it == users_.end()) {
+      return;
+    }
+
+    remove_user(it);
+
+    if (!waiters_.empty()) {
+      auto next = std::move(waiters_.front_payload());
+      auto ev = waiters_.pop();
+      grant(ev, next.key_, std::move(next.on_preempted_));
+    }
+
+    record();
+  }
+
+  /**
+   * Change the priority of a waiting request. The request keeps its position
+   * among the requests of the new priority made at the same time.
+   *
+   * @param request Waiting request.
+   * @param priority New priority.
+   * @return Whether the request is waiting.
+   */
+  bool change_priority(const event_type &request, int priority) {
+    return waiters_.update(
+        request, [priority](waiting &w) { w.key_.priority_ = priority; });
+  }
+
+  /// @return Number of available usage slots.
+  std::uint64_t available() const { return capacity_ - users_.size(); }
+
+  /// @return Number of usage slots.
+  std::uint64_t capacity() const { return capacity_; }
+
+  /// @return Number of waiting requests.
+  std::size_t queued() const { return waiters_.size(); }
+
+  /**
+   * Record the number of waiting requests and the number of used slots in
+   * time-weighted monitors from now on. Each update costs a few arithmetic
+   * operations.
+   *
+   * @param queued Monitor of the number of waiting requests, or nullptr.
+   * @param in_use Monitor of the number of used slots, or nullptr.
+   */
+  void monitor(time_weighted<Time, Policy> *queued,
+               time_weighted<Time, Policy> *in_use = nullptr) {
+    queued_monitor_ = queued;
+    in_use_monitor_ = in_use;
+    record();
+  }
+
+private:
+  /// Callback to be called if a usage slot is preempted, which does nothing.
+  static void ignore(const preemption &) {}
+
+  /// Order of requests.
+  struct key {
+    /// Priority of the request.
+    int priority_;
+
+    /// Incremental ID to order requests by insertion order.
+    std::uint64_t id_;
+
+    /**
+     * @param other Key to compare to.
+     * @return Whether this request is granted before the other request.
+     */
+    bool operator<(const key &other) const {
+      if (priority_ != other.priority_) {
+        return priority_ < other.priority_;
+      }
+
+      return id_ < other.id_;
+    }
+  };
+
+  /// Additional data of a waiting request.
+  struct waiting {
+    /// Order of the request.
+    key key_;
+
+    /// Callback to be called if the usage slot is preempted.
+    preempted_callback on_preempted_;
+
+    /**
+     * @param other Waiting request to compare to.
+     * @return Whether this request is granted before the other request.
+     */
+    bool operator<(const waiting &other) const { return key_ < other.key_; }
+  };
+
+  /// User of a usage slot.
+  struct user {
+    /// Granted request.
+    event_type request_;
+
+    /// Order of the request.
+    key key_;
+
+    /// Time at which the usage slot was granted.
+    Time usage_since_;
+
+    /// Callback to be called if the usage slot is preempted.
+    preempted_callback on_preempted_;
+  };
+
+  /// Update the monitors, if any.
+  void record() {
+    if (queued_monitor_ != nullptr) {
+      queued_monitor_->set(static_cast<double>(queued()));
+    }
+
+    if (in_use_monitor_ != nullptr) {
+      in_use_monitor_->set(static_cast<double>(users_.size()));
+    }
+  }
+
+  /**
+   * Remove a user by moving the last user into its place.
+   *
+   * @param it Iterator to the user.
+   */
+  void remove_user(typename std::vector<user>::iterator it) {
+    if (it != users_.end() - 1) {
+      *it = std::move(users_.back());
+    }
+    users_.pop_back();
+  }
+
+  /**
+   * Grant a usage slot to a request.
+   *
+   * @param ev Request.
+   * @param k Order of the request.
+   * @param on_preempted Callback to be called if the usage slot is preempted.
+   */
+  void grant(const event_type &ev, key k, preempted_callback on_preempted) {
+    users_.push_back(user{ev, k, sim_.now(), std::move(on_preempted)});
+    ev.trigger();
+  }
+
+  /// Reference to the simulation.
+  simulation<Time, Policy> &sim_;
+
+  /// Users of the usage slots.
+  std::vector<user> users_{};
+
+  /// Waiting requests.
+  detail::waiter_heap<event_type, waiting> waiters_;
+
+  /// Number of usage slots.
+  std::uint64_t capacity_;
+
+  /// Next request ID.
+  std::uint64_t next_id_ = 0;
+
+  /// Monitor of the number of waiting requests, or nullptr.
+  time_weighted<Time, Policy> *queued_monitor_ = nullptr;
+
+  /// Monitor of the number of used slots, or nullptr.
+  time_weighted<Time, Policy> *in_use_monitor_ = nullptr;
+};
+} // namespace simcpp20
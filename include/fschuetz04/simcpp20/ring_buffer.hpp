@@ -0,0 +1,79 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <utility> // std::move
+#include <vector>  // std::vector
+
+namespace simcpp20::detail {
+/**
+ * First-in first-out queue in a growable circular buffer. Memory is kept when
+ * elements are removed, so a queue with a stable maximum size does not
+ * allocate memory anymore.
+ *
+ * @tparam T Element type. Must be default constructible.
+ */
+template <typename T> class ring_buffer {
+public:
+  /// @param element Element to add at the back.
+  void push_back(T element) {
+    if (size_ == elements_.size()) {
+      grow();
+    }
+
+    elements_[(head_ + size_) & (elements_.size() - 1)] = std::move(element);
+    ++size_;
+  }
+
+  /// @return Reference to the front element.
+  T &front() {
+    assert(size_ > 0);
+    return elements_[head_];
+  }
+
+  /// @return Reference to the front element.
+  const T &front() const {
+    assert(size_ > 0);
+    return elements_[head_];
+  }
+
+  /// Remove the front element. The element is replaced by a default
+  /// constructed element, so resources held by it are released.
+  void pop_front() {
+    assert(size_ > 0);
+    elements_[head_] = T{};
+    head_ = (head_ + 1) & (elements_.size() - 1);
+    --size_;
+  }
+
+  /// @return Whether the queue is empty.
+  bool empty() const { return size_ == 0; }
+
+  /// @return Number of elements.
+  std::size_t size() const { return size_; }
+
+private:
+  /// Double the capacity, keeping the capacity a power of two.
+  void grow() {
+    std::vector<T> elements(elements_.empty() ? 8 : 2 * elements_.size());
+    for (std::size_t i = 0; i < size_; ++i) {
+      elements[i] = std::move(elements_[(head_ + i) & (elements_.size() - 1)]);
+    }
+
+    elements_ = std::move(elements);
+    head_ = 0;
+  }
+
+  /// Circular buffer. Its size is zero or a power of two.
+  std::vector<T> elements_{};
+
+  /// Index of the front element.
+  std::size_t head_ = 0;
+
+  /// Number of elements.
+  std::size_t size_ = 0;
+};
+} // namespace simcpp20::detail
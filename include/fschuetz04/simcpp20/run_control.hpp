@@ -0,0 +1,194 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert>    // assert
+#include <cstddef>    // std::size_t
+#include <cstdint>    // std::uint64_t
+#include <deque>      // std::deque
+#include <functional> // std::function
+#include <utility>    // std::move
+
+#include "monitor.hpp"
+#include "policy.hpp"
+#include "simulation.hpp"
+
+namespace simcpp20 {
+/**
+ * Run control for steady-state estimation using the method of batch means.
+ *
+ * The simulation runs in batches of a fixed length. After each batch, each
+ * watched statistic is evaluated and added to a tally of its batch means. The
+ * run stops once each statistic has enough batches and the relative half-width
+ * of the confidence interval of its mean is below its target, or once the
+ * horizon is reached:
+ *
+ *     sim.run_until(warm_up);
+ *     queue_length.reset();
+ *
+ *     simcpp20::run_control control{sim, 100.0};
+ *     auto &batches = control.watch(queue_length, 0.05);
+ *     bool converged = control.run_until(1e6);
+ *     double estimate = batches.mean();
+ *
+ * The batch length must be long enough for the batch means to be roughly
+ * independent, otherwise the half-width underestimates the error.
+ *
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulation.
+ */
+template <typename Time = double, typename Policy = default_policy>
+class run_control {
+public:
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation.
+   * @param interval Length of a batch. Must be positive.
+   * @param confidence Confidence level of the half-widths.
+   * @param min_batches Minimum number of batches of each watched statistic
+   * before the run may stop. Must be at least two.
+   */
+  run_control(simulation<Time, Policy> &sim, Time interval,
+              double confidence = 0.95, std::uint64_t min_batches = 10)
+      : sim_{sim}, interval_{interval}, confidence_{confidence},
+        min_batches_{min_batches} {
+    assert(interval > 0);
+    assert(min_batches >= 2);
+  }
+
+  /**
+   * Watch a statistic evaluated once per batch.
+   *
+   * @tparam F Type of the statistic. Must be callable without arguments and
+   * return the value of the statistic for the batch which just ended.
+   * @param batch Statistic, called at the end of each batch.
+   * @param target Target relative half-width, for example 0.05.
+   * @return Reference to the tally of the batch values, valid as long as the
+   * run control exists.
+   */
+  template <typename F> const tally &watch(F batch, double target) {
+    criteria_.push_back(
+        {std::function<double()>{std::move(batch)}, tally{}, target});
+    return criteria_.back().batches_;
+  }
+
+  /**
+   * Watch the mean of a time-weighted statistic per batch. The statistic is
+   * reset at the end of each batch.
+   *
+   * @param stat Reference to the statistic, which must be valid as long as the
+   * run control is used.
+   * @param target Target relative half-width.
+   * @return Reference to the tally of the batch means.
+   */
+  const tally &watch(time_weighted<Time, Policy> &stat, double target) {
+    return watch(
+        [&stat] {
+          double mean = stat.mean();
+          stat.reset();
+          return mean;
+        },
+        target);
+  }
+
+  /**
+   * Watch the mean of the observations per batch. The tally is reset at the
+   * end of each batch. Batches without observations have a mean of 0.
+   *
+   * @param stat Reference to the tally, which must be valid as long as the run
+   * control is used.
+   * @param target Target relative half-width.
+   * @return Reference to the tally of the batch means.
+   */
+  const tally &watch(tally &stat, double target) {
+    return watch(
+        [&stat] {
+          double mean = stat.mean();
+          stat.reset();
+          return mean;
+        },
+        target);
+  }
+
+  /**
+   * Run the simulation batch by batch until all watched statistics are
+   * precise enough or until no full batch fits before the horizon. The
+   * simulation time is then at the end of the last batch, or at the horizon.
+   *
+   * May be called again with a later horizon to continue the run.
+   *
+   * @param horizon Latest simulation time to run until.
+   * @return Whether all watched statistics reached their targets.
+   */
+  bool run_until(Time horizon) {
+    while (!converged()) {
+      Time end = sim_.now() + interval_;
+      if (end > horizon) {
+        sim_.run_until(horizon);
+        return false;
+      }
+
+      sim_.run_until(end);
+      ++n_batches_;
+      for (auto &criterion : criteria_) {
+        criterion.batches_.add(criterion.batch_());
+      }
+    }
+
+    return true;
+  }
+
+  /// @return Whether all watched statistics reached their targets.
+  bool converged() const {
+    if (n_batches_ < min_batches_) {
+      return false;
+    }
+
+    for (auto &criterion : criteria_) {
+      if (criterion.batches_.count() < min_batches_ ||
+          criterion.batches_.relative_half_width(confidence_) >
+              criterion.target_) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /// @return Number of completed batches.
+  std::uint64_t batches() const { return n_batches_; }
+
+private:
+  /// Watched statistic.
+  struct criterion {
+    /// Statistic, called at the end of each batch.
+    std::function<double()> batch_;
+
+    /// Values of the statistic, one per batch.
+    tally batches_;
+
+    /// Target relative half-width.
+    double target_;
+  };
+
+  /// Reference to the simulation.
+  simulation<Time, Policy> &sim_;
+
+  /// Length of a batch.
+  Time interval_;
+
+  /// Confidence level of the half-widths.
+  double confidence_;
+
+  /// Minimum number of batches.
+  std::uint64_t min_batches_;
+
+  /// Number of completed batches.
+  std::uint64_t n_batches_ = 0;
+
+  /// Watched statistics. A deque keeps references to the tallies valid.
+  std::deque<criterion> criteria_{};
+};
+} // namespace simcpp20
@@ -3,21 +3,46 @@
 
 #pragma once
 
-#include <cassert>    // assert
-#include <cstddef>    // std::size_t
-#include <cstdint>    // std::uint64_t
-#include <functional> // std::greater
-#include <memory>     // std::make_shared, std::make_unique
-#include <queue>      // std::priority_queue
-#include <utility>    // std::forward
-#include <vector>     // std::vector
-
+#include <algorithm>          // std::clamp, std::max, std::min
+#include <array>              // std::array
+#include <atomic>             // std::atomic, std::atomic_thread_fence
+#include <cassert>            // assert
+#include <chrono>             // std::chrono::steady_clock, ...
+#include <condition_variable> // std::condition_variable
+#include <coroutine>          // std::coroutine_handle
+#include <cstddef>            // std::size_t
+#include <cstdint>            // std::uint64_t
+#include <iterator>           // std::size
+#include <memory>             // std::unique_ptr, std::make_unique
+#include <mutex>              // std::mutex, std::lock_guard, std::unique_lock
+#include <type_traits>        // std::is_constructible_v, std::is_integral_v
+#include <utility>            // std::forward, std::move, std::pair
+#include <vector>             // std::vector
+
+#include "callback.hpp"
 #include "event.hpp"
+#include "mpsc_queue.hpp"
+#include "ring_buffer.hpp"
 #include "value_event.hpp"
 
 namespace simcpp20 {
 using id_type = std::uint64_t;
 
+/// Statistics of a run paced against the wall clock. See run_realtime.
+struct realtime_stats {
+  /// Number of processed batches of events at the same time.
+  std::size_t batches_ = 0;
+
+  /**
+   * Number of batches whose wall-clock time had already passed once the
+   * previous batch was processed, because the model fell behind.
+   */
+  std::size_t behind_ = 0;
+
+  /// Maximum delay of a batch after its wall-clock time.
+  std::chrono::steady_clock::duration max_lag_{};
+};
+
 /**
  * Used to run a discrete-event simulation.
  *
@@ -25,15 +50,108 @@ using id_type = std::uint64_t;
  *
  *     simcpp20::simulation<> sim;
  *
+ * The shared data of events and the frames of coroutines are allocated by the
+ * allocator of the simulation. Thus, all events and processes must be
+ * destroyed before the simulation, including copies held outside of it.
+ *
  * TODO(fschuetz04): Keep list of pending events to clear them up?
  *
  * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy selecting the implementations used internally. See
+ * default_policy.
  */
-template <typename Time = double> class simulation {
+template <typename Time, typename Policy> class simulation {
 private:
-  using event_type = simcpp20::event<Time>;
+  using event_type = simcpp20::event<Time, Policy>;
 
 public:
+  /**
+   * Awaitable suspending the awaiting coroutine for a delay. In contrast to a
+   * timeout, no event is created. Instead, the coroutine handle itself is
+   * scheduled.
+   */
+  class delay_awaitable {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param sim Reference to the simulation.
+     * @param delay Delay after which to resume the awaiting coroutine.
+     */
+    delay_awaitable(simulation &sim, Time delay) : sim_{sim}, delay_{delay} {}
+
+    /// @return Whether the coroutine can continue without being suspended.
+    bool await_ready() const { return false; }
+
+    /**
+     * Called when a coroutine is suspended after using co_await on the delay.
+     * Schedule the coroutine to be resumed after the delay.
+     *
+     * @tparam Promise Promise type of the coroutine.
+     * @param handle Coroutine handle.
+     */
+    template <typename Promise>
+    void await_suspend(std::coroutine_handle<Promise> handle) {
+      sim_.schedule(handle, handle.promise().ev_, delay_);
+    }
+
+    /**
+     * Called when the coroutine is resumed after the delay. If the event of the
+     * coroutine is aborted before, the coroutine is destroyed instead.
+     */
+    void await_resume() const {}
+
+    /**
+     * Convert the delay to a timeout, if an event is needed after all.
+     *
+     * @return New pending event which is processed after the delay.
+     */
+    operator event_type() const { return sim_.timeout(delay_); }
+
+  private:
+    /// Reference to the simulation.
+    simulation &sim_;
+
+    /// Delay after which to resume the awaiting coroutine.
+    Time delay_;
+  };
+
+  /// Constructor.
+  simulation() = default;
+
+  /**
+   * Constructor. The allocator borrows the memory of a parent allocator and
+   * returns it once the simulation is destroyed, so consecutive simulations,
+   * for example the replications run by one thread, reuse their memory.
+   *
+   * @param parent Parent allocator. Must outlive the simulation and must not
+   * be used by anything else until the simulation is destroyed.
+   */
+  explicit simulation(typename Policy::allocator *parent)
+    requires std::is_constructible_v<typename Policy::allocator,
+                                     typename Policy::allocator *>
+      : allocator_{parent} {}
+
+  simulation(const simulation &) = delete;
+  simulation &operator=(const simulation &) = delete;
+
+  /**
+   * Destructor. Destroy all coroutines which are scheduled without an event.
+   * Coroutines awaiting an event are destroyed with the event.
+   */
+  ~simulation() {
+    destroy_retired();
+
+    while (!empty()) {
+      auto sev = pop_next();
+      if (sev.is_coroutine()) {
+        sev.coroutine().handle_.destroy();
+      } else {
+        sev.release();
+      }
+    }
+  }
+
   /// @return New pending event.
   event_type event() { return event_type{*this}; }
 
@@ -41,8 +159,8 @@ public:
    * @tparam Value Value type of the event.
    * @return New pending value event.
    */
-  template <typename Value> value_event<Value, Time> event() {
-    return value_event<Value, Time>{*this};
+  template <typename Value> value_event<Value, Time, Policy> event() {
+    return value_event<Value, Time, Policy>{*this};
   }
 
   /**
@@ -62,13 +180,24 @@ public:
    * @return New pending value event.
    */
   template <typename Value, typename... Args>
-  value_event<Value, Time> timeout(Time delay, Args &&...args) {
+  value_event<Value, Time, Policy> timeout(Time delay, Args &&...args) {
     auto ev = event<Value>();
     ev.set_value(std::forward<Args>(args)...);
     schedule(ev, delay);
     return ev;
   }
 
+  /**
+   * Use as co_await sim.delay(delay) to suspend the current process for the
+   * given delay. Cheaper than co_await sim.timeout(delay), since no event is
+   * created. If the result is converted to an event, a timeout is created
+   * instead.
+   *
+   * @param delay Delay after which to resume the awaiting coroutine.
+   * @return Awaitable suspending the awaiting coroutine for the delay.
+   */
+  delay_awaitable delay(Time delay) { return {*this, delay}; }
+
   /**
    * @param evs List of events.
    * @return New pending event which is triggered when any of the given events
@@ -85,11 +214,11 @@ public:
       }
     }
 
-    auto any_of_ev = event();
+    auto cond = new (*this) typename event_type::condition{*this, 1};
+    event_type any_of_ev{cond};
 
     for (const auto &ev : evs) {
-      ev.add_callback(
-          [any_of_ev](const auto &) mutable { any_of_ev.trigger(); });
+      cond->add_child(ev.data_);
     }
 
     return any_of_ev;
@@ -113,16 +242,11 @@ public:
       return timeout(0);
     }
 
-    auto all_of_ev = event();
-    auto n_ptr = std::make_shared<std::size_t>(n);
+    auto cond = new (*this) typename event_type::condition{*this, n};
+    event_type all_of_ev{cond};
 
     for (const auto &ev : evs) {
-      ev.add_callback([all_of_ev, n_ptr](const auto &) mutable {
-        --*n_ptr;
-        if (*n_ptr == 0) {
-          all_of_ev.trigger();
-        }
-      });
+      cond->add_child(ev.data_);
     }
 
     return all_of_ev;
@@ -135,16 +259,197 @@ public:
   void schedule(event_type ev, Time delay = Time{0}) {
     assert(delay >= Time{0});
 
-    scheduled_evs_.emplace(now() + delay, next_id_, ev);
+    push(scheduled_event{now() + delay, next_id_, ev});
     ++next_id_;
   }
 
-  /// Process the next scheduled event.
+  /**
+   * Schedule multiple events at once. Events are processed in the order of
+   * the range if scheduled for the same time. Depending on the event queue,
+   * this is faster than scheduling each event, for example by building the
+   * heap in linear time.
+   *
+   * @tparam Range Type of the range. Its elements must be pairs of a delay and
+   * an event.
+   * @param evs Range of pairs of a delay after which to process the event and
+   * the event to be processed.
+   */
+  template <typename Range> void schedule_batch(const Range &evs) {
+    std::vector<scheduled_event> batch;
+    if constexpr (requires { std::size(evs); }) {
+      batch.reserve(std::size(evs));
+    }
+
+    for (const auto &[delay, ev] : evs) {
+      assert(delay >= Time{0});
+      scheduled_event sev{now() + delay, next_id_, ev};
+      ++next_id_;
+      observer_.on_schedule(now_, sev.time_, sev.id_);
+
+      if (sev.time_ == now_) {
+        now_evs_.push_back(std::move(sev));
+      } else {
+        track(sev);
+        batch.push_back(std::move(sev));
+      }
+    }
+
+    if constexpr (requires { scheduled_evs_.push_batch(std::move(batch)); }) {
+      scheduled_evs_.push_batch(std::move(batch));
+    } else {
+      for (auto &sev : batch) {
+        scheduled_evs_.push(std::move(sev));
+      }
+    }
+  }
+
+  /**
+   * Create and schedule multiple timeouts at once. See schedule_batch.
+   *
+   * @tparam Range Type of the range. Its elements must be delays.
+   * @param delays Range of delays after which to process the timeouts.
+   * @return New pending events, one per delay.
+   */
+  template <typename Range>
+  std::vector<event_type> timeout_batch(const Range &delays) {
+    std::vector<std::pair<Time, event_type>> batch;
+    if constexpr (requires { std::size(delays); }) {
+      batch.reserve(std::size(delays));
+    }
+
+    for (const auto &delay : delays) {
+      batch.emplace_back(delay, event());
+    }
+
+    schedule_batch(batch);
+
+    std::vector<event_type> evs;
+    evs.reserve(batch.size());
+    for (auto &[delay, ev] : batch) {
+      evs.push_back(std::move(ev));
+    }
+
+    return evs;
+  }
+
+  /**
+   * Start a stream of arrivals, for example of customers, without a source
+   * process. The first arrival happens at the current simulation time, each
+   * further arrival after an interarrival time drawn from the distribution.
+   *
+   *     sim.arrivals(std::exponential_distribution<>{1. / 10}, gen,
+   *                  [&](std::uint64_t i) { customer(sim, i); });
+   *
+   * Each arrival is a single timeout with a callback calling the factory and
+   * scheduling the next arrival, instead of a coroutine awaiting timeouts.
+   * Interarrival times are drawn in blocks, so a generator shared with other
+   * parts of the model produces a different sequence than drawing one time
+   * per arrival.
+   *
+   * @tparam Distribution Type of the distribution.
+   * @tparam Generator Type of the random number generator.
+   * @tparam Factory Type of the factory.
+   * @param dist Distribution of the interarrival times.
+   * @param gen Reference to the random number generator. Must be valid until
+   * the last arrival.
+   * @param factory Function called with the index of each arrival, usually
+   * starting a process.
+   * @param n Number of arrivals. Unlimited by default.
+   * @return Event processed after the last arrival.
+   */
+  template <typename Distribution, typename Generator, typename Factory>
+  event_type arrivals(Distribution dist, Generator &gen, Factory factory,
+                      std::uint64_t n = ~std::uint64_t{0}) {
+    auto done = event();
+    if (n == 0) {
+      done.trigger();
+      return done;
+    }
+
+    using stream_type = arrival_stream<Distribution, Generator, Factory>;
+    auto stream = std::make_unique<stream_type>(
+        *this, std::move(dist), gen, std::move(factory), n, done);
+    auto &first = *stream;
+    first.schedule(std::move(stream), Time{0});
+    return done;
+  }
+
+  /**
+   * Post a function from another thread. The function is called by the thread
+   * running the simulation at the start of the next step or when poll is
+   * called, at the simulation time of that moment.
+   *
+   * This is the only member function which may be called while another
+   * thread runs the simulation. The function must not capture events, since
+   * copying an event from another thread is not thread-safe. Instead, it can
+   * for example put a value into a store:
+   *
+   *     sim.post([&feed, value](auto &) { feed.put(value); });
+   *
+   * Functions posted by the same thread are called in the order they are
+   * posted.
+   *
+   * @tparam F Type of the function. Must be callable with a reference to the
+   * simulation.
+   * @param f Function.
+   */
+  template <typename F> void post(F &&f) {
+    posted_.push(detail::callback<simulation &>{std::forward<F>(f)});
+
+    // pairs with the fence in wait_for_post, so either this thread sees the
+    // waiting flag or the waiting thread sees the posted function
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_.load(std::memory_order_relaxed)) {
+      {
+        // the waiting thread either did not check for posted functions yet or
+        // waits on the condition variable
+        std::lock_guard lock{wake_mutex_};
+      }
+      wake_cv_.notify_one();
+    }
+  }
+
+  /// Call all functions posted from other threads. See post.
+  void poll() {
+    posted_.consume([this](auto &&f) { f(*this); });
+  }
+
+  /**
+   * Process the next scheduled event. Entries of aborted events are skipped
+   * without advancing the current time.
+   */
   void step() {
-    auto sev = scheduled_evs_.top();
-    scheduled_evs_.pop();
+    if constexpr (Policy::symmetric_transfer) {
+      destroy_retired();
+    }
+
+    if (!posted_.empty()) {
+      poll();
+
+      // posted functions may abort all scheduled events, after which
+      // compaction leaves nothing to process
+      if (empty()) {
+        return;
+      }
+    }
+
+    auto sev = pop_next();
+    if (sev.is_dead()) {
+      // dead entries do not advance the clock, whether they are skipped here
+      // or removed by compact before
+      sev.release();
+      return;
+    }
+
     now_ = sev.time_;
-    sev.ev_.process();
+    observer_.on_step(now_, sev.id_, now_evs_.size() + scheduled_evs_.size());
+
+    if (sev.is_coroutine()) {
+      observer_.on_resume(now_);
+      sev.coroutine().resume();
+    } else {
+      sev.take_event().process();
+    }
   }
 
   /// Run the simulation until no more events are scheduled.
@@ -164,21 +469,269 @@ public:
   void run_until(Time target) {
     assert(target >= now());
 
-    while (!empty() && scheduled_evs_.top().time_ < target) {
+    while (!empty() && next_time() < target) {
       step();
     }
 
     now_ = target;
   }
 
+  /**
+   * Run the simulation until the target time is reached, pacing it against
+   * the wall clock. All events scheduled at the same time are processed as
+   * one batch, after sleeping until the wall-clock time of the batch. While
+   * sleeping, functions posted from other threads are called immediately at
+   * the simulation time matching the wall clock, so they may schedule new
+   * events. See post.
+   *
+   * If the model processes a batch slower than the wall clock advances, the
+   * following batches are processed without sleeping until the model caught
+   * up. How far the model fell behind is reported in the returned statistics.
+   *
+   * @param target Target time. Reached on the wall clock as well, even if no
+   * more events are scheduled.
+   * @param factor Simulation time units per wall-clock second. Must be
+   * positive.
+   * @return Statistics of the run.
+   */
+  realtime_stats run_realtime(Time target, double factor = 1) {
+    assert(target >= now());
+    assert(factor > 0);
+
+    using clock = std::chrono::steady_clock;
+    auto start_wall = clock::now();
+    auto start = now_;
+    auto wall_time = [&](Time time) {
+      std::chrono::duration<double> offset{static_cast<double>(time - start) /
+                                           factor};
+      return start_wall + std::chrono::duration_cast<clock::duration>(offset);
+    };
+
+    realtime_stats stats;
+    while (true) {
+      poll();
+
+      Time next = empty() ? target : std::min(next_time(), target);
+      auto due = wall_time(next);
+      auto now_wall = clock::now();
+      bool behind = now_wall >= due;
+      if (!behind && wait_for_post(due)) {
+        // advance to the simulation time matching the wall clock, which is
+        // not after the next event, and call the posted functions there
+        std::chrono::duration<double> elapsed = clock::now() - start_wall;
+        now_ = std::clamp(start + static_cast<Time>(elapsed.count() * factor),
+                          now_, next);
+        continue;
+      }
+
+      if (next >= target) {
+        break;
+      }
+
+      if (behind && stats.batches_ > 0) {
+        stats.behind_ += 1;
+      }
+
+      stats.max_lag_ = std::max(stats.max_lag_, clock::now() - due);
+      stats.batches_ += 1;
+      while (!empty() && next_time() == next) {
+        step();
+      }
+    }
+
+    now_ = target;
+    return stats;
+  }
+
   /// @return Whether no events are scheduled.
-  bool empty() const { return scheduled_evs_.empty(); }
+  bool empty() const { return now_evs_.empty() && scheduled_evs_.empty(); }
+
+  /**
+   * @return Time of the next scheduled event. Must only be called if events
+   * are scheduled.
+   */
+  Time next_time() const {
+    assert(!empty());
+    return next_is_now() ? now_ : scheduled_evs_.top().time_;
+  }
 
   /// @return Current simulation time.
   Time now() const { return now_; }
 
+  /// @return Reference to the allocator for the shared data of events.
+  typename Policy::allocator &allocator() { return allocator_; }
+
+  /// @return Reference to the observer selected by the policy.
+  typename Policy::observer &observer() { return observer_; }
+
 private:
-  /// One event scheduled to be processed.
+  /**
+   * Keep the frame of a returned coroutine until the next step. Used for
+   * symmetric transfer, where a coroutine cannot destroy its own frame before
+   * transferring control.
+   *
+   * @param handle Handle of the returned coroutine.
+   */
+  void retire(std::coroutine_handle<> handle) { retired_.push_back(handle); }
+
+  /// Destroy the frames of all returned coroutines kept by retire.
+  void destroy_retired() {
+    for (auto handle : retired_) {
+      handle.destroy();
+    }
+    retired_.clear();
+  }
+
+  /**
+   * Sleep until the given time or until a function is posted.
+   *
+   * @param until Wall-clock time until which to sleep.
+   * @return Whether a function was posted.
+   */
+  bool wait_for_post(std::chrono::steady_clock::time_point until) {
+    std::unique_lock lock{wake_mutex_};
+    waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool posted =
+        wake_cv_.wait_until(lock, until, [this] { return !posted_.empty(); });
+    waiting_.store(false, std::memory_order_relaxed);
+    return posted;
+  }
+
+  /// Suspended coroutine, together with the event associated with it.
+  using suspended_coroutine = typename event_type::suspended_coroutine;
+
+  /**
+   * @param handle Coroutine to be resumed.
+   * @param ev Event associated with the coroutine. If it is aborted before the
+   * delay passed, the coroutine is destroyed instead of being resumed.
+   * @param delay Delay after which to resume the coroutine.
+   */
+  void schedule(std::coroutine_handle<> handle, const event_type &ev,
+                Time delay) {
+    assert(delay >= Time{0});
+
+    push(scheduled_event{now() + delay, next_id_,
+                         suspended_coroutine{handle, &ev}});
+    ++next_id_;
+  }
+
+  /**
+   * State of a stream of arrivals started by arrivals. The stream is owned by
+   * the callback of the timeout of its next arrival, so it is destroyed
+   * together with the timeout if the simulation ends before the last arrival.
+   *
+   * @tparam Distribution Type of the distribution.
+   * @tparam Generator Type of the random number generator.
+   * @tparam Factory Type of the factory.
+   */
+  template <typename Distribution, typename Generator, typename Factory>
+  class arrival_stream {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param sim Reference to the simulation.
+     * @param dist Distribution of the interarrival times.
+     * @param gen Reference to the random number generator.
+     * @param factory Function called with the index of each arrival.
+     * @param n Number of arrivals.
+     * @param done Event triggered after the last arrival.
+     */
+    arrival_stream(simulation &sim, Distribution dist, Generator &gen,
+                   Factory factory, std::uint64_t n, event_type done)
+        : sim_{sim}, dist_{std::move(dist)}, gen_{gen},
+          factory_{std::move(factory)}, n_{n}, done_{std::move(done)} {}
+
+    /**
+     * Schedule the next arrival.
+     *
+     * @param self Owner of this stream.
+     * @param delay Delay after which the next arrival happens.
+     */
+    void schedule(std::unique_ptr<arrival_stream> self, Time delay) {
+      sim_.timeout(delay).add_callback(
+          [self = std::move(self)](const event_type &) mutable {
+            auto &stream = *self;
+            stream.arrive(std::move(self));
+          });
+    }
+
+  private:
+    /// Number of interarrival times drawn at once.
+    static constexpr std::size_t block_size = 64;
+
+    /**
+     * Call the factory for the current arrival and schedule the next one.
+     *
+     * @param self Owner of this stream.
+     */
+    void arrive(std::unique_ptr<arrival_stream> self) {
+      factory_(i_);
+      ++i_;
+      if (i_ == n_) {
+        done_.trigger();
+        return;
+      }
+
+      if (next_ == n_drawn_) {
+        n_drawn_ = static_cast<std::size_t>(
+            std::min<std::uint64_t>(block_size, n_ - i_));
+        for (std::size_t j = 0; j < n_drawn_; ++j) {
+          block_[j] = static_cast<Time>(dist_(gen_));
+        }
+
+        next_ = 0;
+      }
+
+      schedule(std::move(self), block_[next_++]);
+    }
+
+    /// Reference to the simulation.
+    simulation &sim_;
+
+    /// Distribution of the interarrival times.
+    Distribution dist_;
+
+    /// Reference to the random number generator.
+    Generator &gen_;
+
+    /// Function called with the index of each arrival.
+    Factory factory_;
+
+    /// Number of arrivals.
+    std::uint64_t n_;
+
+    /// Event triggered after the last arrival.
+    event_type done_;
+
+    /// Index of the next arrival.
+    std::uint64_t i_ = 0;
+
+    /// Drawn interarrival times.
+    std::array<Time, block_size> block_{};
+
+    /// Number of drawn interarrival times in the block.
+    std::size_t n_drawn_ = 0;
+
+    /// Index of the next interarrival time in the block.
+    std::size_t next_ = 0;
+  };
+
+  /// Shared data of an event.
+  using event_data = typename event_type::data;
+
+  /**
+   * One event or coroutine scheduled to be processed.
+   *
+   * Scheduled events are copied around by the event queue, so they are kept
+   * trivially copyable if the time is: an event is stored as a raw pointer to
+   * its shared data, a coroutine as its address and a pointer to its event.
+   * A scheduled event for an event holds one use of the shared data, which
+   * is not managed automatically, but taken over by take_event or given up
+   * by release once the scheduled event is removed.
+   */
   class scheduled_event {
   public:
     /**
@@ -189,14 +742,76 @@ private:
      * insertion order.
      * @param ev Event to process.
      */
-    scheduled_event(Time time, id_type id, event_type ev)
-        : time_{time}, id_{id}, ev_{ev} {}
+    scheduled_event(Time time, id_type id, const event_type &ev)
+        : time_{time}, id_{id}, target_{ev.data_} {
+      ev.data_->use_count_ += 1;
+    }
+
+    /**
+     * Constructor.
+     *
+     * @param time Time at which to resume the coroutine.
+     * @param id_ Incremental ID to sort events scheduled at the same time by
+     * insertion order.
+     * @param coroutine Coroutine to resume.
+     */
+    scheduled_event(Time time, id_type id, suspended_coroutine coroutine)
+        : time_{time}, id_{id}, target_{coroutine.handle_.address()},
+          ev_{coroutine.ev_} {}
+
+    /// Constructor. Used for unused slots of the FIFO.
+    scheduled_event() = default;
+
+    /// @return Whether a coroutine is scheduled instead of an event.
+    bool is_coroutine() const { return ev_ != nullptr; }
+
+    /// @return Whether the scheduled event is aborted, so the entry is dead.
+    bool is_dead() const {
+      return !is_coroutine() && data()->state_ == event_type::state::aborted;
+    }
+
+    /// @return Shared data of the scheduled event. Must not be a coroutine.
+    event_data *data() const {
+      assert(!is_coroutine());
+      return static_cast<event_data *>(target_);
+    }
+
+    /// @return Scheduled coroutine. Must be a coroutine.
+    suspended_coroutine coroutine() const {
+      assert(is_coroutine());
+      return {std::coroutine_handle<>::from_address(target_), ev_};
+    }
+
+    /**
+     * Take over the use of the shared data held by this scheduled event.
+     * Must not be a coroutine.
+     *
+     * @return Event.
+     */
+    event_type take_event() const {
+      event_type ev{data()};
+      data()->use_count_ -= 1;
+      return ev;
+    }
+
+    /// Give up the use of the shared data held by this scheduled event, if any.
+    void release() const {
+      if (!is_coroutine()) {
+        data()->release();
+      }
+    }
 
     /**
      * @param other Scheduled event to compare to.
      * @return Whether this event is scheduled before the given event.
      */
     bool operator>(const scheduled_event &other) const {
+      if constexpr (std::is_integral_v<Time>) {
+        // integral times compare exactly, so the comparison is branchless
+        return (time_ > other.time_) |
+               ((time_ == other.time_) & (id_ > other.id_));
+      }
+
       if (time_ != other.time_) {
         return time_ > other.time_;
       }
@@ -205,27 +820,189 @@ private:
     }
 
     /// Time at which to process the event.
-    Time time_;
+    Time time_{};
 
     /**
      * Incremental ID to sort events scheduled at the same time by insertion
      * order.
      */
-    id_type id_;
+    id_type id_ = 0;
+
+  private:
+    /// Shared data of the event to process or address of the coroutine.
+    void *target_ = nullptr;
 
-    /// Event to process.
-    event_type ev_;
+    /// Event associated with the coroutine, or nullptr for an event.
+    const event_type *ev_ = nullptr;
   };
 
+  /**
+   * Queue a scheduled event. Events scheduled for the current time are added
+   * to a FIFO instead of the event queue, since they are processed in
+   * insertion order anyway.
+   *
+   * @param sev Scheduled event.
+   */
+  void push(scheduled_event sev) {
+    observer_.on_schedule(now_, sev.time_, sev.id_);
+
+    if (sev.time_ == now_) {
+      now_evs_.push_back(std::move(sev));
+    } else {
+      track(sev);
+      scheduled_evs_.push(std::move(sev));
+    }
+  }
+
+  /**
+   * Count a scheduled event added to the event queue, so aborting the event
+   * marks its entries as dead.
+   *
+   * @param sev Scheduled event.
+   */
+  void track(const scheduled_event &sev) {
+    if (!sev.is_coroutine()) {
+      sev.data()->scheduled_ += 1;
+      if (sev.data()->state_ == event_type::state::aborted) {
+        dead_ += 1;
+      }
+    }
+  }
+
+  /**
+   * Called when an event with entries in the event queue is aborted. The
+   * entries are not removed immediately, but skipped when popped. Once dead
+   * entries make up more than half of the event queue, they are removed all
+   * at once, so models aborting many timeouts do not grow the event queue.
+   * Either way, dead entries never advance the current time.
+   *
+   * @param n Number of entries of the aborted event.
+   */
+  void cancel(std::size_t n) {
+    dead_ += n;
+    if (dead_ >= min_compaction && 2 * dead_ > scheduled_evs_.size()) {
+      compact();
+    }
+  }
+
+  /// Remove the entries of all aborted events from the event queue.
+  void compact() {
+    // the events are released after the event queue is consistent again,
+    // since releasing an event may destroy coroutines aborting other events
+    std::vector<event_type> removed;
+    removed.reserve(dead_);
+    auto is_dead = [&removed](const scheduled_event &sev) {
+      if (!sev.is_dead()) {
+        return false;
+      }
+
+      sev.data()->scheduled_ -= 1;
+      removed.push_back(sev.take_event());
+      return true;
+    };
+
+    if constexpr (requires { scheduled_evs_.remove_if(is_dead); }) {
+      scheduled_evs_.remove_if(is_dead);
+    } else {
+      std::vector<scheduled_event> alive;
+      while (!scheduled_evs_.empty()) {
+        auto sev = scheduled_evs_.top();
+        scheduled_evs_.pop();
+        if (!is_dead(sev)) {
+          alive.push_back(std::move(sev));
+        }
+      }
+
+      if constexpr (requires { scheduled_evs_.push_batch(std::move(alive)); }) {
+        scheduled_evs_.push_batch(std::move(alive));
+      } else {
+        for (auto &sev : alive) {
+          scheduled_evs_.push(std::move(sev));
+        }
+      }
+    }
+
+    dead_ = 0;
+  }
+
+  /**
+   * Events in the event queue scheduled for the current time were scheduled
+   * before the current time was reached, so before all events in the FIFO.
+   * They are thus processed first.
+   *
+   * @return Whether the next event is the front of the FIFO.
+   */
+  bool next_is_now() const {
+    return !now_evs_.empty() &&
+           (scheduled_evs_.empty() || now_ < scheduled_evs_.top().time_);
+  }
+
+  /// @return Next scheduled event, which is removed.
+  scheduled_event pop_next() {
+    if (next_is_now()) {
+      auto sev = std::move(now_evs_.front());
+      now_evs_.pop_front();
+      return sev;
+    }
+
+    auto sev = scheduled_evs_.top();
+    scheduled_evs_.pop();
+
+    if (!sev.is_coroutine()) {
+      sev.data()->scheduled_ -= 1;
+      if (sev.data()->state_ == event_type::state::aborted) {
+        dead_ -= 1;
+      }
+    }
+
+    return sev;
+  }
+
+  /**
+   * Allocator for the shared data of events. Declared first, so it is
+   * destroyed after all scheduled events.
+   */
+  typename Policy::allocator allocator_{};
+
   /// Scheduled events.
-  std::priority_queue<scheduled_event, std::vector<scheduled_event>,
-                      std::greater<scheduled_event>>
-      scheduled_evs_{};
+  typename Policy::template queue<scheduled_event> scheduled_evs_{};
+
+  /// Events scheduled for the current time, in insertion order.
+  detail::ring_buffer<scheduled_event> now_evs_{};
 
   /// Current simulation time.
   Time now_ = Time{0};
 
   /// Next ID for scheduling an event.
   id_type next_id_ = 0;
+
+  /// Number of entries of aborted events in the event queue.
+  std::size_t dead_ = 0;
+
+  /// Minimum number of dead entries before the event queue is compacted.
+  static constexpr std::size_t min_compaction = 64;
+
+  /// Frames of returned coroutines to destroy before the next step.
+  std::vector<std::coroutine_handle<>> retired_ = {};
+
+  /// Observer selected by the policy.
+  [[no_unique_address]] typename Policy::observer observer_{};
+
+  /// Functions posted from other threads.
+  detail::mpsc_queue<detail::callback<simulation &>> posted_{};
+
+  /// Whether run_realtime sleeps and must be woken up by post.
+  std::atomic<bool> waiting_{false};
+
+  /// Mutex used to wake up run_realtime.
+  std::mutex wake_mutex_{};
+
+  /// Condition variable used to wake up run_realtime.
+  std::condition_variable wake_cv_{};
+
+  friend event_type;
+  friend class simcpp20::process<Time, Policy>;
+
+  template <typename, typename, typename> friend class simcpp20::value_event;
 };
 } // namespace simcpp20
@@ -0,0 +1,166 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <algorithm>   // std::move
+#include <cassert>     // assert
+#include <cstddef>     // std::size_t
+#include <memory>      // std::uninitialized_move_n, std::destroy_n
+#include <new>         // operator new, operator delete
+#include <type_traits> // std::is_nothrow_move_constructible_v
+#include <utility>     // std::forward, std::move
+
+namespace simcpp20::detail {
+/**
+ * Vector storing up to a fixed number of elements inline. Only if more
+ * elements are added, the elements are moved to memory allocated on the heap.
+ *
+ * @tparam T Element type. Must be nothrow move constructible.
+ * @tparam N Number of elements stored inline.
+ */
+template <typename T, std::size_t N> class small_vector {
+  static_assert(N > 0, "small_vector requires inline storage");
+  static_assert(std::is_nothrow_move_constructible_v<T>,
+                "small_vector requires nothrow move constructible elements");
+
+public:
+  /// Constructor.
+  small_vector() = default;
+
+  small_vector(const small_vector &) = delete;
+  small_vector &operator=(const small_vector &) = delete;
+
+  /// Destructor.
+  ~small_vector() {
+    clear();
+    if (!is_inline()) {
+      ::operator delete(data_);
+    }
+  }
+
+  /**
+   * Construct a new element at the end.
+   *
+   * @tparam Args Types of arguments to construct the element with.
+   * @param args Arguments to construct the element with.
+   * @return Reference to the new element.
+   */
+  template <typename... Args> T &emplace_back(Args &&...args) {
+    if (size_ == capacity_) {
+      grow();
+    }
+
+    T *element = new (data_ + size_) T(std::forward<Args>(args)...);
+    ++size_;
+    return *element;
+  }
+
+  /// @param element Element to add at the end.
+  void push_back(T element) { emplace_back(std::move(element)); }
+
+  /**
+   * Remove an element by moving the last element into its place. Does not
+   * preserve the order of the elements.
+   *
+   * @param element Pointer to the element to remove.
+   */
+  void swap_remove(T *element) {
+    assert(element >= begin() && element < end());
+
+    T *last = data_ + size_ - 1;
+    if (element != last) {
+      *element = std::move(*last);
+    }
+
+    last->~T();
+    --size_;
+  }
+
+  /**
+   * Remove an element by moving all following elements one position forward.
+   * Preserves the order of the elements.
+   *
+   * @param element Pointer to the element to remove.
+   */
+  void erase(T *element) {
+    assert(element >= begin() && element < end());
+
+    std::move(element + 1, end(), element);
+    pop_back();
+  }
+
+  /// Remove the last element.
+  void pop_back() {
+    assert(size_ > 0);
+    --size_;
+    data_[size_].~T();
+  }
+
+  /// Destroy all elements. Keeps allocated memory.
+  void clear() {
+    std::destroy_n(data_, size_);
+    size_ = 0;
+  }
+
+  /// @return Whether the vector is empty.
+  bool empty() const { return size_ == 0; }
+
+  /// @return Number of elements.
+  std::size_t size() const { return size_; }
+
+  /**
+   * @param i Index of the element.
+   * @return Reference to the element.
+   */
+  T &operator[](std::size_t i) {
+    assert(i < size_);
+    return data_[i];
+  }
+
+  /// @return Reference to the last element.
+  T &back() {
+    assert(size_ > 0);
+    return data_[size_ - 1];
+  }
+
+  /// @return Pointer to the first element.
+  T *begin() { return data_; }
+
+  /// @return Pointer past the last element.
+  T *end() { return data_ + size_; }
+
+private:
+  /// @return Whether the elements are stored inline.
+  bool is_inline() const {
+    return data_ == reinterpret_cast<const T *>(storage_);
+  }
+
+  /// Double the capacity and move the elements to newly allocated memory.
+  void grow() {
+    std::size_t capacity = 2 * capacity_;
+    T *data = static_cast<T *>(::operator new(capacity * sizeof(T)));
+    std::uninitialized_move_n(data_, size_, data);
+    std::destroy_n(data_, size_);
+
+    if (!is_inline()) {
+      ::operator delete(data_);
+    }
+
+    data_ = data;
+    capacity_ = capacity;
+  }
+
+  /// Inline storage.
+  alignas(T) unsigned char storage_[N * sizeof(T)];
+
+  /// Pointer to the first element, either to storage_ or to heap memory.
+  T *data_ = reinterpret_cast<T *>(storage_);
+
+  /// Number of elements.
+  std::size_t size_ = 0;
+
+  /// Number of elements which fit into the current memory.
+  std::size_t capacity_ = N;
+};
+} // namespace simcpp20::detail
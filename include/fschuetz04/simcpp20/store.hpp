@@ -0,0 +1,153 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <deque>   // std::deque
+#include <limits>  // std::numeric_limits
+#include <utility> // std::move
+
+#include "monitor.hpp"
+#include "simulation.hpp"
+#include "value_event.hpp"
+#include "waiter_list.hpp"
+
+namespace simcpp20 {
+/**
+ * Store holding a limited number of items. Puts wait while the store is full,
+ * gets wait while it is empty. Both are granted in the order they are made,
+ * and items are taken in the order they are put.
+ *
+ * @tparam Item Type of the stored items. Must be move constructible.
+ * @tparam Time Type used for simulation time.
+ * @tparam Policy Policy of the simulation.
+ */
+template <typename Item, typename Time = double,
+          typename Policy = default_policy>
+class store {
+public:
+  /// Event type.
+  using event_type = event<Time, Policy>;
+
+  /// Event type of gets.
+  using get_event_type = value_event<Item, Time, Policy>;
+
+  /**
+   * Constructor.
+   *
+   * @param sim Reference to the simulation.
+   * @param capacity Maximum number of items.
+   */
+  explicit store(simulation<Time, Policy> &sim,
+                 std::size_t capacity = std::numeric_limits<std::size_t>::max())
+      : sim_{sim}, capacity_{capacity} {
+    assert(capacity_ > 0);
+  }
+
+  store(const store &) = delete;
+  store &operator=(const store &) = delete;
+
+  /**
+   * @param item Item to put into the store.
+   * @return Pending event which is triggered once the item is put into the
+   * store.
+   */
+  event_type put(Item item) {
+    auto ev = sim_.event();
+    if (puts_.empty() && items_.size() < capacity_) {
+      items_.push_back(std::move(item));
+      ev.trigger();
+      trigger();
+    } else {
+      puts_.push_back(ev, std::move(item));
+    }
+
+    return ev;
+  }
+
+  /**
+   * @return Pending event which is triggered with the next item once the store
+   * is not empty.
+   */
+  get_event_type get() {
+    auto ev = sim_.template event<Item>();
+    if (gets_.empty() && !items_.empty()) {
+      ev.trigger(std::move(items_.front()));
+      items_.pop_front();
+      trigger();
+    } else {
+      gets_.push_back(ev);
+    }
+
+    return ev;
+  }
+
+  /// @return Number of stored items.
+  std::size_t size() const { return items_.size(); }
+
+  /// @return Maximum number of items.
+  std::size_t capacity() const { return capacity_; }
+
+  /// @return Number of waiting puts.
+  std::size_t queued_puts() const { return puts_.size(); }
+
+  /// @return Number of waiting gets.
+  std::size_t queued_gets() const { return gets_.size(); }
+
+  /**
+   * Record the number of stored items in a time-weighted monitor from now on.
+   *
+   * @param size Monitor of the number of stored items, or nullptr.
+   */
+  void monitor(time_weighted<Time, Policy> *size) {
+    size_monitor_ = size;
+    trigger();
+  }
+
+private:
+  /// Grant waiting puts and gets until the first put and the first get must
+  /// wait.
+  void trigger() {
+    bool progress = true;
+    while (progress) {
+      progress = false;
+
+      while (!puts_.empty() && items_.size() < capacity_) {
+        items_.push_back(std::move(puts_.front_payload()));
+        puts_.pop_front().trigger();
+        progress = true;
+      }
+
+      while (!gets_.empty() && !items_.empty()) {
+        gets_.pop_front().trigger(std::move(items_.front()));
+        items_.pop_front();
+        progress = true;
+      }
+    }
+
+    if (size_monitor_ != nullptr) {
+      size_monitor_->set(static_cast<double>(items_.size()));
+    }
+  }
+
+  /// Reference to the simulation.
+  simulation<Time, Policy> &sim_;
+
+  /// Stored items.
+  std::deque<Item> items_{};
+
+  /// Waiting puts with their items.
+  detail::waiter_list<event_type, Item> puts_{};
+
+  /// Waiting gets.
+  detail::waiter_list<get_event_type> gets_{};
+
+  /// Maximum number of items.
+  std::size_t capacity_;
+
+  /// Monitor of the number of stored items, or nullptr.
+  time_weighted<Time, Policy> *size_monitor_ = nullptr;
+};
+} // namespace simcpp20
@@ -0,0 +1,299 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint32_t
+#include <cstdio>  // std::FILE, std::fopen, std::fwrite, std::setvbuf, ...
+#include <cstring> // std::memcmp, std::memcpy
+#include <span>    // std::span
+#include <utility> // std::exchange
+#include <vector>  // std::vector
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h> // CreateFileA, CreateFileMappingA, MapViewOfFile, ...
+#else
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+#endif
+
+#include "observer.hpp"
+
+namespace simcpp20 {
+/**
+ * Header of a binary trace file. It is followed by the records, stored in the
+ * native byte order.
+ */
+struct trace_file_header {
+  /// Identifies trace files.
+  char magic_[8] = {'S', 'I', 'M', 'C', 'P', 'P', '2', '0'};
+
+  /// Version of the format.
+  std::uint32_t version_ = 1;
+
+  /// Size of one record in bytes.
+  std::uint32_t record_size_ = sizeof(trace_record);
+};
+
+static_assert(sizeof(trace_file_header) == 16);
+
+/**
+ * Trace sink writing the records to a binary file. Records are collected in a
+ * buffer and written in large blocks.
+ *
+ * Use as trace_observer<trace_file_writer> and open the file before running
+ * the simulation:
+ *
+ *     sim.observer().sink().open("trace.bin");
+ */
+class trace_file_writer {
+public:
+  /// Constructor.
+  trace_file_writer() = default;
+
+  trace_file_writer(const trace_file_writer &) = delete;
+  trace_file_writer &operator=(const trace_file_writer &) = delete;
+
+  /// Destructor. Write the remaining records and close the file.
+  ~trace_file_writer() { close(); }
+
+  /**
+   * Open a file and write the header. A file opened before is closed.
+   *
+   * @param path Path of the file, which is replaced if it exists.
+   * @return Whether the file was opened.
+   */
+  bool open(const char *path) {
+    close();
+
+    file_ = std::fopen(path, "wb");
+    if (file_ == nullptr) {
+      return false;
+    }
+
+    // records are already buffered
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+    failed_ = false;
+
+    trace_file_header header;
+    if (std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+      close();
+      return false;
+    }
+
+    buffer_.reserve(buffer_size);
+    return true;
+  }
+
+  /**
+   * @param record Record to write. If no file is open, the record is
+   * discarded.
+   */
+  void write(const trace_record &record) {
+    if (file_ == nullptr) {
+      return;
+    }
+
+    buffer_.push_back(record);
+    if (buffer_.size() == buffer_size) {
+      flush();
+    }
+  }
+
+  /// Write all buffered records to the file.
+  void flush() {
+    if (file_ == nullptr || buffer_.empty()) {
+      return;
+    }
+
+    auto n = std::fwrite(buffer_.data(), sizeof(trace_record), buffer_.size(),
+                         file_);
+    failed_ = failed_ || n != buffer_.size();
+    buffer_.clear();
+  }
+
+  /// Write the remaining records and close the file, if one is open.
+  void close() {
+    if (file_ == nullptr) {
+      return;
+    }
+
+    flush();
+    std::fclose(std::exchange(file_, nullptr));
+  }
+
+  /// @return Whether writing a record failed since the file was opened.
+  bool failed() const { return failed_; }
+
+private:
+  /// Number of records written at once.
+  static constexpr std::size_t buffer_size = 4096;
+
+  /// Open file, or nullptr.
+  std::FILE *file_ = nullptr;
+
+  /// Records not written yet.
+  std::vector<trace_record> buffer_{};
+
+  /// Whether writing a record failed.
+  bool failed_ = false;
+};
+
+/**
+ * Reader of a binary trace file. The file is mapped into memory, so the
+ * records are accessed without copying them, and traces larger than the
+ * memory are read page by page by the operating system.
+ */
+class trace_file_reader {
+public:
+  /// Constructor.
+  trace_file_reader() = default;
+
+  trace_file_reader(const trace_file_reader &) = delete;
+  trace_file_reader &operator=(const trace_file_reader &) = delete;
+
+  /// Destructor. Unmap the file.
+  ~trace_file_reader() { close(); }
+
+  /**
+   * Map a trace file into memory. A file opened before is closed.
+   *
+   * @param path Path of the file.
+   * @return Whether the file was mapped and has a valid header.
+   */
+  bool open(const char *path) {
+    close();
+    if (!map(path)) {
+      return false;
+    }
+
+    trace_file_header expected;
+    trace_file_header header;
+    if (size_ < sizeof(header)) {
+      close();
+      return false;
+    }
+
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic_, expected.magic_, sizeof(header.magic_)) !=
+            0 ||
+        header.version_ != expected.version_ ||
+        header.record_size_ != expected.record_size_) {
+      close();
+      return false;
+    }
+
+    return true;
+  }
+
+  /// Unmap the file, if one is mapped.
+  void close() {
+    if (data_ == nullptr) {
+      return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    munmap(data_, size_);
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  /// @return Records of the file. Empty if no file is open.
+  std::span<const trace_record> records() const {
+    if (data_ == nullptr) {
+      return {};
+    }
+
+    // the header keeps the records aligned to 8 bytes
+    auto first = reinterpret_cast<const trace_record *>(
+        static_cast<const char *>(data_) + sizeof(trace_file_header));
+    return {first, (size_ - sizeof(trace_file_header)) / sizeof(trace_record)};
+  }
+
+  /// @return Iterator to the first record.
+  auto begin() const { return records().begin(); }
+
+  /// @return Iterator after the last record.
+  auto end() const { return records().end(); }
+
+  /// @return Number of records.
+  std::size_t size() const { return records().size(); }
+
+private:
+  /**
+   * @param path Path of the file.
+   * @return Whether the file was mapped into memory.
+   */
+  bool map(const char *path) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+      CloseHandle(file);
+      return false;
+    }
+
+    // the view keeps the mapping and the file open
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+      return false;
+    }
+
+    data_ = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (data_ == nullptr) {
+      return false;
+    }
+
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    return true;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      return false;
+    }
+
+    // the mapping keeps the file open
+    auto size = static_cast<std::size_t>(st.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+
+    data_ = data;
+    size_ = size;
+    return true;
+#endif
+  }
+
+  /// Mapped file, or nullptr.
+  void *data_ = nullptr;
+
+  /// Size of the mapped file in bytes.
+  std::size_t size_ = 0;
+};
+} // namespace simcpp20
@@ -4,8 +4,10 @@
 #pragma once
 
 #include <cassert>   // assert
-#include <coroutine> // std::suspend_never
-#include <utility>   // std::forward, std::exchange
+#include <coroutine> // std::coroutine_handle, std::noop_coroutine, ...
+#include <cstddef>   // std::max_align_t
+#include <optional>  // std::optional
+#include <utility>   // std::forward
 
 namespace simcpp20 {
 /**
@@ -13,16 +15,21 @@ namespace simcpp20 {
  *
  * @tparam Time Type used for simulation time.
  * @tparam Value Type of the value.
+ * @tparam Policy Policy of the simulation.
  */
-template <typename Value, class Time = double>
-class value_event : public event<Time> {
+template <typename Value, class Time = double, class Policy = default_policy>
+class value_event : public event<Time, Policy> {
+private:
+  using event_type = simcpp20::event<Time, Policy>;
+
 public:
   /**
    * Constructor.
    *
    * @param simulation Reference to the simulation.
    */
-  explicit value_event(simulation<Time> &sim) : event<Time>{new data(sim)} {}
+  explicit value_event(simulation<Time, Policy> &sim)
+      : event_type{new (sim) data(sim)} {}
 
   /**
    * Set the event state to triggered, and schedule it to be processed
@@ -34,15 +41,15 @@ public:
    * @param args Arguments to construct the event value with.
    */
   template <typename... Args> void trigger(Args &&...args) const {
-    assert(event<Time>::awaiting_ev_ == nullptr);
-    assert(event<Time>::data_ != nullptr);
+    assert(event_type::awaiting_ev_ == nullptr);
+    assert(event_type::data_ != nullptr);
 
-    if (!event<Time>::pending()) {
+    if (!event_type::pending()) {
       return;
     }
 
     set_value(std::forward<Args>(args)...);
-    event<Time>::trigger();
+    event_type::trigger();
   }
 
   /**
@@ -53,18 +60,18 @@ public:
    * @return Value of the event.
    */
   Value &await_resume() {
-    assert(event<Time>::data_ != nullptr);
+    assert(event_type::data_ != nullptr);
 
-    event<Time>::await_resume();
+    event_type::await_resume();
     return value();
   }
 
   /// @return Value of the event.
   Value &value() const {
-    assert(event<Time>::awaiting_ev_ == nullptr);
-    assert(event<Time>::data_ != nullptr);
+    assert(event_type::awaiting_ev_ == nullptr);
+    assert(event_type::data_ != nullptr);
 
-    auto casted_data = static_cast<data *>(event<Time>::data_);
+    auto casted_data = static_cast<data *>(event_type::data_);
     return *casted_data->value_;
   }
 
@@ -79,7 +86,7 @@ public:
      * @param sim Reference to the simulation.
      */
     template <typename... Args>
-    explicit promise_type(simulation<Time> &sim, Args &&...)
+    explicit promise_type(simulation<Time, Policy> &sim, Args &&...)
         : sim_{sim}, ev_{sim} {}
 
     /**
@@ -92,7 +99,7 @@ public:
      * @param sim Reference to the simulation.
      */
     template <typename Class, typename... Args>
-    explicit promise_type(Class &&, simulation<Time> &sim, Args &&...)
+    explicit promise_type(Class &&, simulation<Time, Policy> &sim, Args &&...)
         : sim_{sim}, ev_{sim} {}
 
     /**
@@ -108,6 +115,66 @@ public:
     template <typename Class, typename... Args>
     explicit promise_type(Class &&c, Args &&...) : sim_{c.sim}, ev_{c.sim} {}
 
+    /**
+     * Allocate the coroutine frame using the allocator of the simulation.
+     *
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame in bytes.
+     * @param sim Reference to the simulation.
+     * @return Pointer to the coroutine frame.
+     */
+    template <typename... Args>
+    static void *operator new(std::size_t size, simulation<Time, Policy> &sim,
+                              Args &&...) {
+      return allocate_frame(&sim.allocator(), size);
+    }
+
+    /**
+     * Allocate the coroutine frame using the allocator of the simulation.
+     *
+     * @tparam Class Class type if the coroutine function is a lambda or a
+     * member function of a class.
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame in bytes.
+     * @param sim Reference to the simulation.
+     * @return Pointer to the coroutine frame.
+     */
+    template <typename Class, typename... Args>
+    static void *operator new(std::size_t size, Class &&,
+                              simulation<Time, Policy> &sim, Args &&...) {
+      return allocate_frame(&sim.allocator(), size);
+    }
+
+    /**
+     * Allocate the coroutine frame using the allocator of the simulation.
+     *
+     * @tparam Class Class type if the coroutine function is a member function
+     * of a class. Must contain a member variable sim referencing the simulation
+     * instance.
+     * @tparam Args Types of additional arguments passed to the coroutine
+     * function.
+     * @param size Size of the coroutine frame in bytes.
+     * @param c Class instance.
+     * @return Pointer to the coroutine frame.
+     */
+    template <typename Class, typename... Args>
+    static void *operator new(std::size_t size, Class &&c, Args &&...) {
+      return allocate_frame(&c.sim.allocator(), size);
+    }
+
+    /**
+     * Deallocate the coroutine frame.
+     *
+     * @param ptr Pointer to the coroutine frame.
+     * @param size Size of the coroutine frame in bytes.
+     */
+    SIMCPP20_FRAME_DELETE static void operator delete(void *ptr,
+                                                      std::size_t size) {
+      deallocate_frame<typename Policy::allocator>(ptr, size);
+    }
+
 #ifdef __INTELLISENSE__
     // IntelliSense fix. See https://stackoverflow.com/q/67209981.
     promise_type();
@@ -119,64 +186,88 @@ public:
      * @return Value event associated with the coroutine. This event is
      * triggered when the coroutine returns with the value it returns.
      */
-    value_event<Value, Time> get_return_object() const { return ev_; }
+    value_event<Value, Time, Policy> get_return_object() const { return ev_; }
 
     /**
-     * Called when the coroutine is started. The coroutine awaits the return
-     * value before running.
+     * Called when the coroutine is started. Unless the policy requests an
+     * eager start, the coroutine awaits the return value before running.
      *
-     * @return Event which will be processed at the current simulation time.
+     * @return Awaitable which is always ready if the start is eager, otherwise
+     * a delay of 0, so the coroutine runs at the current simulation time after
+     * all events already scheduled for that time.
      */
-    event<Time> initial_suspend() const { return sim_.timeout(Time{0}); }
+    auto initial_suspend() const {
+      if constexpr (Policy::eager_start) {
+        return std::suspend_never{};
+      } else {
+        return sim_.delay(Time{0});
+      }
+    }
 
     /// Called when an exception is thrown inside the coroutine and not handled.
     void unhandled_exception() const { assert(false); }
 
     /**
      * Called when the coroutine returns. Trigger the event associated with the
-     * coroutine with the value returned by the coroutine.
+     * coroutine with the value returned by the coroutine. If the policy
+     * enables symmetric transfer and exactly one coroutine awaits the event,
+     * that coroutine is resumed directly instead.
      *
      * @tparam Types of arguments to construct the return value with.
      * @parma Arguments to construct the return value with.
      */
-    template <typename... Args> void return_value(Args &&...args) const {
-      ev_.trigger(std::forward<Args>(args)...);
+    template <typename... Args> void return_value(Args &&...args) {
+      if constexpr (Policy::symmetric_transfer) {
+        if (ev_.pending()) {
+          ev_.set_value(std::forward<Args>(args)...);
+        }
+
+        next_ = ev_.trigger_or_transfer();
+      } else {
+        ev_.trigger(std::forward<Args>(args)...);
+      }
     }
 
     /**
      * Called after the coroutine returns.
      *
-     * @return Awaitable which is always ready.
+     * @return Awaitable transferring control to the coroutine to resume next
+     * if the policy enables symmetric transfer, otherwise awaitable which is
+     * always ready.
      */
-    std::suspend_never final_suspend() const noexcept { return {}; }
+    auto final_suspend() const noexcept {
+      if constexpr (Policy::symmetric_transfer) {
+        return typename event_type::final_awaitable{next_};
+      } else {
+        return std::suspend_never{};
+      }
+    }
 
     /// Reference to the simulation.
-    simulation<Time> &sim_;
+    simulation<Time, Policy> &sim_;
 
     /**
      * Value event associated with the coroutine. This event is triggered when
      * the coroutine returns with the value the coroutine returns.
      */
-    value_event<Value, Time> ev_;
+    value_event<Value, Time, Policy> ev_;
+
+    /// Coroutine to resume after this coroutine returns.
+    std::coroutine_handle<> next_ = std::noop_coroutine();
   };
 
 private:
   /// Shared data of the event.
-  class data : public event<Time>::data {
-  public:
-    using event<Time>::data::data;
-
-    /// Destructor.
-    ~data() override {
-      event<Time>::data::~data();
+  class data : public event_type::data {
+    // the allocator of the simulation only guarantees fundamental alignment
+    static_assert(alignof(Value) <= alignof(std::max_align_t),
+                  "over-aligned value types are not supported");
 
-      if (value_ != nullptr) {
-        delete std::exchange(value_, nullptr);
-      }
-    }
+  public:
+    using event_type::data::data;
 
-    /// Value of the event.
-    Value *value_ = nullptr;
+    /// Value of the event, stored inline to avoid a separate allocation.
+    std::optional<Value> value_ = {};
   };
 
   /**
@@ -184,10 +275,10 @@ private:
    * @param args Arguments to construct the event value with.
    */
   template <typename... Args> void set_value(Args &&...args) const {
-    auto casted_data = static_cast<data *>(event<Time>::data_);
-    casted_data->value_ = new Value(std::forward<Args>(args)...);
+    auto casted_data = static_cast<data *>(event_type::data_);
+    casted_data->value_.emplace(std::forward<Args>(args)...);
   }
 
-  friend class simulation<Time>;
+  friend class simulation<Time, Policy>;
 };
 } // namespace simcpp20
@@ -0,0 +1,239 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <new>     // placement new
+#include <utility> // std::forward, std::move, std::swap
+#include <vector>  // std::vector
+
+#include "callback.hpp"
+#include "waiter_list.hpp"
+
+namespace simcpp20::detail {
+/**
+ * Priority queue of pending events, for example requests waiting for a
+ * resource by priority. The heap is indexed: Each entry stores its position in
+ * the heap and the event links back to its entry, so an aborted event is
+ * removed and the key of an event is changed in logarithmic time.
+ *
+ * Entries are allocated using the allocator of the simulation. Each entry
+ * holds a reference to its event.
+ *
+ * @tparam Event Event type.
+ * @tparam Payload Type of additional data stored with each event. Entries are
+ * ordered using operator< of the payload, the smallest entry is the front.
+ */
+template <typename Event, typename Payload> class waiter_heap {
+public:
+  /**
+   * Constructor.
+   *
+   * @param on_cancel Callback to be called after an event is removed because
+   * it is aborted.
+   */
+  explicit waiter_heap(callback<waiter_heap &> on_cancel = ignore)
+      : on_cancel_{std::move(on_cancel)} {}
+
+  waiter_heap(const waiter_heap &) = delete;
+  waiter_heap &operator=(const waiter_heap &) = delete;
+
+  /// Destructor. Remove all events.
+  ~waiter_heap() {
+    while (!empty()) {
+      erase(entries_.back());
+    }
+  }
+
+  /**
+   * Add a pending event.
+   *
+   * @param ev Pending event. Must not wait in another list or heap.
+   * @param payload Additional data stored with the event.
+   */
+  void push(const Event &ev, Payload payload) {
+    assert(ev.pending());
+    assert(ev.data_->waiter_ == nullptr);
+
+    void *ptr = ev.data_->sim_.allocator().allocate(sizeof(node));
+    auto entry = new (ptr) node{*this, ev, std::move(payload)};
+    ev.data_->waiter_ = entry;
+
+    entry->index_ = entries_.size();
+    entries_.push_back(entry);
+    sift_up(entry->index_);
+  }
+
+  /// @return Reference to the front event.
+  const Event &front() const {
+    assert(!empty());
+    return entries_.front()->ev_;
+  }
+
+  /// @return Reference to the additional data of the front event.
+  Payload &front_payload() {
+    assert(!empty());
+    return entries_.front()->payload_;
+  }
+
+  /// @return Front event, which is removed.
+  Event pop() {
+    assert(!empty());
+    Event ev = entries_.front()->ev_;
+    erase(entries_.front());
+    return ev;
+  }
+
+  /**
+   * Change the additional data of an event and restore the heap order.
+   *
+   * @tparam F Type of the function.
+   * @param ev Event.
+   * @param f Function called with a reference to the additional data of the
+   * event.
+   * @return Whether the event waits in this heap.
+   */
+  template <typename F> bool update(const Event &ev, F &&f) {
+    auto entry = find(ev);
+    if (entry == nullptr) {
+      return false;
+    }
+
+    std::forward<F>(f)(entry->payload_);
+    sift_up(entry->index_);
+    sift_down(entry->index_);
+    return true;
+  }
+
+  /// @return Whether the heap is empty.
+  bool empty() const { return entries_.empty(); }
+
+  /// @return Number of events.
+  std::size_t size() const { return entries_.size(); }
+
+private:
+  /// Entry of one event.
+  class node final : public waiter {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param heap Heap containing the entry.
+     * @param ev Event.
+     * @param payload Additional data stored with the event.
+     */
+    node(waiter_heap &heap, Event ev, Payload payload)
+        : waiter{&heap}, heap_{heap}, ev_{std::move(ev)},
+          payload_{std::move(payload)} {}
+
+    /// Remove the entry from its heap. Called when the event is aborted.
+    void cancel() override {
+      auto &heap = heap_;
+      heap.erase(this);
+      heap.on_cancel_(heap);
+    }
+
+    /// Heap containing the entry.
+    waiter_heap &heap_;
+
+    /// Position of the entry in the heap.
+    std::size_t index_ = 0;
+
+    /// Event.
+    Event ev_;
+
+    /// Additional data stored with the event.
+    Payload payload_;
+  };
+
+  /**
+   * @param ev Event.
+   * @return Entry of the event if it waits in this heap, otherwise nullptr.
+   */
+  node *find(const Event &ev) const {
+    auto entry = ev.data_->waiter_;
+    if (entry == nullptr || entry->owner() != this) {
+      return nullptr;
+    }
+
+    // only the nodes of this heap are owned by it
+    return static_cast<node *>(entry);
+  }
+
+  /// @param entry Entry to unlink and destroy.
+  void erase(node *entry) {
+    std::size_t i = entry->index_;
+    std::size_t last = entries_.size() - 1;
+    if (i != last) {
+      swap(i, last);
+    }
+    entries_.pop_back();
+
+    if (i != last) {
+      sift_up(i);
+      sift_down(i);
+    }
+
+    auto &allocator = entry->ev_.data_->sim_.allocator();
+    entry->ev_.data_->waiter_ = nullptr;
+    entry->~node();
+    allocator.deallocate(entry, sizeof(node));
+  }
+
+  /// @param i Index of the entry to move towards the root.
+  void sift_up(std::size_t i) {
+    while (i > 0) {
+      std::size_t parent = (i - 1) / 2;
+      if (!(entries_[i]->payload_ < entries_[parent]->payload_)) {
+        break;
+      }
+
+      swap(i, parent);
+      i = parent;
+    }
+  }
+
+  /// @param i Index of the entry to move towards the leaves.
+  void sift_down(std::size_t i) {
+    std::size_t n = entries_.size();
+    while (true) {
+      std::size_t min = i;
+      for (std::size_t child = 2 * i + 1; child <= 2 * i + 2; ++child) {
+        if (child < n && entries_[child]->payload_ < entries_[min]->payload_) {
+          min = child;
+        }
+      }
+
+      if (min == i) {
+        break;
+      }
+
+      swap(i, min);
+      i = min;
+    }
+  }
+
+  /**
+   * Swap two entries and update their positions.
+   *
+   * @param i Index of the first entry.
+   * @param j Index of the second entry.
+   */
+  void swap(std::size_t i, std::size_t j) {
+    std::swap(entries_[i], entries_[j]);
+    entries_[i]->index_ = i;
+    entries_[j]->index_ = j;
+  }
+
+  /// Entries in heap order.
+  std::vector<node *> entries_{};
+
+  /// Callback to be called after an event is removed, which does nothing.
+  static void ignore(waiter_heap &) {}
+
+  /// Callback to be called after an event is removed because it is aborted.
+  callback<waiter_heap &> on_cancel_;
+};
+} // namespace simcpp20::detail
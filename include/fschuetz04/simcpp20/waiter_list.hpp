@@ -0,0 +1,201 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#pragma once
+
+#include <cassert> // assert
+#include <cstddef> // std::size_t
+#include <new>     // placement new
+#include <utility> // std::move
+#include <variant> // std::monostate
+
+#include "callback.hpp"
+
+namespace simcpp20::detail {
+/**
+ * Entry of a pending event in a waiter list. The shared data of the event
+ * points to its entry, so the entry is removed when the event is aborted.
+ */
+class waiter {
+public:
+  /// Remove the entry from its list. Called when the event is aborted.
+  virtual void cancel() = 0;
+
+  /// @return List or heap containing the entry.
+  const void *owner() const { return owner_; }
+
+protected:
+  /// @param owner List or heap containing the entry.
+  explicit waiter(const void *owner) : owner_{owner} {}
+
+  /// Destructor.
+  ~waiter() = default;
+
+private:
+  /**
+   * List or heap containing the entry, so a heap finds its own entries
+   * without RTTI.
+   */
+  const void *owner_;
+};
+
+/**
+ * First-in first-out list of pending events, for example requests waiting for
+ * a resource. The list is intrusive: Each entry is linked to its neighbours
+ * and the event links back to its entry, so an aborted event is removed in
+ * constant time instead of being skipped once it reaches the front.
+ *
+ * Entries are allocated using the allocator of the simulation. Each entry
+ * holds a reference to its event.
+ *
+ * @tparam Event Event type.
+ * @tparam Payload Type of additional data stored with each event.
+ */
+template <typename Event, typename Payload = std::monostate>
+class waiter_list {
+public:
+  /**
+   * Constructor.
+   *
+   * @param on_cancel Callback to be called after an event is removed because
+   * it is aborted.
+   */
+  explicit waiter_list(callback<waiter_list &> on_cancel = ignore)
+      : on_cancel_{std::move(on_cancel)} {}
+
+  waiter_list(const waiter_list &) = delete;
+  waiter_list &operator=(const waiter_list &) = delete;
+
+  /// Destructor. Remove all events.
+  ~waiter_list() {
+    while (!empty()) {
+      erase(head_);
+    }
+  }
+
+  /**
+   * Add a pending event at the back.
+   *
+   * @param ev Pending event. Must not wait in another list.
+   * @param payload Additional data stored with the event.
+   */
+  void push_back(const Event &ev, Payload payload = {}) {
+    assert(ev.pending());
+    assert(ev.data_->waiter_ == nullptr);
+
+    void *ptr = ev.data_->sim_.allocator().allocate(sizeof(node));
+    auto entry = new (ptr) node{*this, ev, std::move(payload)};
+    ev.data_->waiter_ = entry;
+
+    entry->prev_ = tail_;
+    if (tail_ != nullptr) {
+      tail_->next_ = entry;
+    } else {
+      head_ = entry;
+    }
+    tail_ = entry;
+    ++size_;
+  }
+
+  /// @return Reference to the front event.
+  const Event &front() const {
+    assert(!empty());
+    return head_->ev_;
+  }
+
+  /// @return Reference to the additional data of the front event.
+  Payload &front_payload() {
+    assert(!empty());
+    return head_->payload_;
+  }
+
+  /// @return Front event, which is removed.
+  Event pop_front() {
+    assert(!empty());
+    Event ev = head_->ev_;
+    erase(head_);
+    return ev;
+  }
+
+  /// @return Whether the list is empty.
+  bool empty() const { return size_ == 0; }
+
+  /// @return Number of events.
+  std::size_t size() const { return size_; }
+
+private:
+  /// Entry of one event.
+  class node final : public waiter {
+  public:
+    /**
+     * Constructor.
+     *
+     * @param list List containing the entry.
+     * @param ev Event.
+     * @param payload Additional data stored with the event.
+     */
+    node(waiter_list &list, Event ev, Payload payload)
+        : waiter{&list}, list_{list}, ev_{std::move(ev)},
+          payload_{std::move(payload)} {}
+
+    /// Remove the entry from its list. Called when the event is aborted.
+    void cancel() override {
+      auto &list = list_;
+      list.erase(this);
+      list.on_cancel_(list);
+    }
+
+    /// List containing the entry.
+    waiter_list &list_;
+
+    /// Previous entry.
+    node *prev_ = nullptr;
+
+    /// Next entry.
+    node *next_ = nullptr;
+
+    /// Event.
+    Event ev_;
+
+    /// Additional data stored with the event.
+    Payload payload_;
+  };
+
+  /// @param entry Entry to unlink and destroy.
+  void erase(node *entry) {
+    if (entry->prev_ != nullptr) {
+      entry->prev_->next_ = entry->next_;
+    } else {
+      head_ = entry->next_;
+    }
+
+    if (entry->next_ != nullptr) {
+      entry->next_->prev_ = entry->prev_;
+    } else {
+      tail_ = entry->prev_;
+    }
+
+    --size_;
+
+    auto &allocator = entry->ev_.data_->sim_.allocator();
+    entry->ev_.data_->waiter_ = nullptr;
+    entry->~node();
+    allocator.deallocate(entry, sizeof(node));
+  }
+
+  /// First entry.
+  node *head_ = nullptr;
+
+  /// Last entry.
+  node *tail_ = nullptr;
+
+  /// Number of entries.
+  std::size_t size_ = 0;
+
+  /// Callback to be called after an event is removed, which does nothing.
+  static void ignore(waiter_list &) {}
+
+  /// Callback to be called after an event is removed because it is aborted.
+  callback<waiter_list &> on_cancel_;
+};
+} // namespace simcpp20::detail
@@ -0,0 +1,13 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include "fschuetz04/simcpp20/instantiations.hpp"
+
+namespace simcpp20 {
+template class event<double>;
+template class event<std::uint64_t>;
+template class process<double>;
+template class process<std::uint64_t>;
+template class simulation<double>;
+template class simulation<std::uint64_t>;
+} // namespace simcpp20
@@ -0,0 +1,185 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+TEST_CASE("pool_allocator recycles blocks of the same size class") {
+  simcpp20::pool_allocator allocator;
+
+  auto a = allocator.allocate(24);
+  auto b = allocator.allocate(24);
+  REQUIRE(a != b);
+
+  allocator.deallocate(a, 24);
+  REQUIRE(allocator.allocate(20) == a);
+
+  auto large = allocator.allocate(simcpp20::pool_allocator::max_size + 1);
+  allocator.deallocate(large, simcpp20::pool_allocator::max_size + 1);
+  allocator.deallocate(b, 24);
+}
+
+TEST_CASE("pool_allocator borrows and returns the memory of a parent") {
+  simcpp20::pool_allocator parent;
+  auto a = parent.allocate(24);
+  parent.deallocate(a, 24);
+
+  void *b = nullptr;
+  {
+    simcpp20::simulation<> sim{&parent};
+    REQUIRE(sim.allocator().allocate(24) == a);
+    b = sim.allocator().allocate(24);
+    sim.allocator().deallocate(b, 24);
+  }
+
+  // the block freed by the simulation is reused by the parent
+  REQUIRE(parent.allocate(24) == b);
+  parent.deallocate(a, 24);
+  parent.deallocate(b, 24);
+}
+
+/// Allocator tracking the number of outstanding bytes.
+class counting_allocator {
+public:
+  void *allocate(std::size_t size) {
+    ++allocations;
+    outstanding += size;
+    return ::operator new(size);
+  }
+
+  void deallocate(void *ptr, std::size_t size) {
+    outstanding -= size;
+    ::operator delete(ptr, size);
+  }
+
+  static inline std::size_t allocations = 0;
+  static inline std::size_t outstanding = 0;
+};
+
+struct counting_policy : simcpp20::default_policy {
+  using allocator = counting_allocator;
+};
+
+simcpp20::value_event<std::array<char, 100>, double, counting_policy>
+producer(simcpp20::simulation<double, counting_policy> &sim) {
+  co_await sim.timeout(1);
+  co_return std::array<char, 100>{'a'};
+}
+
+simcpp20::event<double, counting_policy>
+consumer(simcpp20::simulation<double, counting_policy> &sim, char &value) {
+  auto result = co_await producer(sim);
+  value = result[0];
+}
+
+TEST_CASE("shared data of events is returned to the allocator") {
+  counting_allocator::outstanding = 0;
+
+  {
+    simcpp20::simulation<double, counting_policy> sim;
+    char value = 0;
+    consumer(sim, value);
+    auto ev = sim.timeout<std::vector<int>>(2, 3, 1);
+    REQUIRE(counting_allocator::outstanding > 0);
+
+    sim.run();
+
+    REQUIRE(value == 'a');
+    REQUIRE(ev.value().size() == 3);
+  }
+
+  REQUIRE(counting_allocator::outstanding == 0);
+}
+
+TEST_CASE("value events store their value inline") {
+  simcpp20::simulation<double, counting_policy> sim;
+  counting_allocator::allocations = 0;
+
+  auto ev = sim.timeout<int>(1, 42);
+
+  REQUIRE(counting_allocator::allocations == 1);
+  REQUIRE(ev.value() == 42);
+}
+
+struct counting_model {
+  simcpp20::event<double, counting_policy> run() {
+    co_await sim.timeout(1);
+    ++n_runs;
+  }
+
+  simcpp20::simulation<double, counting_policy> &sim;
+  int n_runs = 0;
+};
+
+TEST_CASE("coroutine frames are allocated by the simulation allocator") {
+  counting_allocator::outstanding = 0;
+
+  {
+    simcpp20::simulation<double, counting_policy> sim;
+    counting_model model{sim};
+    auto lambda = [](simcpp20::simulation<double, counting_policy> &sim,
+                     int &n_runs) -> simcpp20::event<double, counting_policy> {
+      co_await sim.timeout(1);
+      ++n_runs;
+    };
+
+    counting_allocator::allocations = 0;
+    model.run();
+    lambda(sim, model.n_runs);
+
+    // frame and event of each process
+    REQUIRE(counting_allocator::allocations == 4);
+
+    sim.run();
+
+    REQUIRE(model.n_runs == 2);
+  }
+
+  REQUIRE(counting_allocator::outstanding == 0);
+}
+
+simcpp20::event<> aligned_local(simcpp20::simulation<> &sim,
+                                 std::uintptr_t &address) {
+  alignas(std::max_align_t) char local[16] = {};
+  co_await sim.timeout(1);
+  address = reinterpret_cast<std::uintptr_t>(&local[0]);
+}
+
+TEST_CASE("coroutine frames have the alignment of the global operator new") {
+  simcpp20::simulation<> sim;
+  std::uintptr_t address = 1;
+  aligned_local(sim, address);
+  sim.run();
+
+  REQUIRE(address % alignof(std::max_align_t) == 0);
+}
+
+simcpp20::event<double, counting_policy>
+interrupted_worker(simcpp20::simulation<double, counting_policy> &sim,
+                   simcpp20::event<double, counting_policy> failure,
+                   int n_parts, std::size_t &outstanding) {
+  for (int i = 0; i < n_parts; ++i) {
+    co_await(sim.timeout(1) | failure);
+    if (i == 10) {
+      outstanding = counting_allocator::outstanding;
+    }
+  }
+
+  REQUIRE(counting_allocator::outstanding == outstanding);
+}
+
+TEST_CASE("any_of does not keep conditions alive on pending events") {
+  simcpp20::simulation<double, counting_policy> sim;
+  auto failure = sim.event();
+  std::size_t outstanding = 0;
+  interrupted_worker(sim, failure, 1000, outstanding);
+
+  sim.run();
+
+  REQUIRE(outstanding > 0);
+}
@@ -0,0 +1,81 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+simcpp20::event<> visitor(simcpp20::simulation<> &sim, std::uint64_t i,
+                          std::vector<std::uint64_t> &order) {
+  co_await sim.timeout(0.5);
+  order.push_back(i);
+}
+
+TEST_CASE("arrivals follow the interarrival distribution") {
+  simcpp20::simulation<> sim;
+  std::default_random_engine gen{42};
+  std::vector<double> times;
+  auto done = sim.arrivals(std::exponential_distribution<>{2}, gen,
+                           [&](std::uint64_t i) {
+                             REQUIRE(i == times.size());
+                             times.push_back(sim.now());
+                           },
+                           1000);
+  sim.run();
+
+  REQUIRE(done.processed());
+  REQUIRE(times.size() == 1000);
+  REQUIRE(times[0] == 0);
+
+  // interarrival times are drawn in order, in blocks
+  std::default_random_engine expected_gen{42};
+  std::exponential_distribution<> dist{2};
+  double expected = 0;
+  for (std::size_t i = 1; i < times.size(); ++i) {
+    expected += dist(expected_gen);
+    REQUIRE(times[i] == expected);
+  }
+}
+
+TEST_CASE("arrivals start processes") {
+  simcpp20::simulation<> sim;
+  std::default_random_engine gen{42};
+  std::vector<std::uint64_t> order;
+  std::uniform_real_distribution<> dist{1, 2};
+  auto done = sim.arrivals(
+      dist, gen, [&](std::uint64_t i) { visitor(sim, i, order); }, 3);
+
+  sim.run_until(0.25);
+  REQUIRE(order.empty());
+  REQUIRE(!done.processed());
+
+  sim.run();
+  REQUIRE(order == std::vector<std::uint64_t>{0, 1, 2});
+  REQUIRE(done.processed());
+}
+
+TEST_CASE("unlimited arrivals end with the simulation") {
+  int n = 0;
+  std::default_random_engine gen{42};
+
+  {
+    simcpp20::simulation<> sim;
+    auto done = sim.arrivals(std::exponential_distribution<>{1}, gen,
+                             [&](std::uint64_t) { ++n; });
+    sim.run_until(1000);
+    REQUIRE(!done.processed());
+  }
+
+  // the stream is destroyed together with the simulation
+  REQUIRE(n > 900);
+  REQUIRE(n < 1100);
+
+  simcpp20::simulation<> sim;
+  auto done = sim.arrivals(std::exponential_distribution<>{1}, gen,
+                           [&](std::uint64_t) { ++n; }, 0);
+  sim.run();
+  REQUIRE(done.processed());
+}
@@ -0,0 +1,47 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <array>
+#include <memory>
+#include <utility>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+TEST_CASE("small_vector moves elements to the heap when growing") {
+  simcpp20::detail::small_vector<std::unique_ptr<int>, 2> vec;
+
+  for (int i = 0; i < 5; ++i) {
+    vec.emplace_back(std::make_unique<int>(i));
+  }
+
+  REQUIRE(vec.size() == 5);
+  for (int i = 0; i < 5; ++i) {
+    REQUIRE(*vec[i] == i);
+  }
+
+  vec.swap_remove(&vec[1]);
+  REQUIRE(vec.size() == 4);
+  REQUIRE(*vec[1] == 4);
+
+  vec.clear();
+  REQUIRE(vec.empty());
+}
+
+TEST_CASE("callback stores small and large callables") {
+  int sum = 0;
+  simcpp20::detail::callback<int> small = [&sum](int x) { sum += x; };
+
+  std::array<int, 32> large_capture{};
+  large_capture[0] = 10;
+  simcpp20::detail::callback<int> large = [&sum, large_capture](int x) {
+    sum += large_capture[0] * x;
+  };
+
+  auto moved_small = std::move(small);
+  auto moved_large = std::move(large);
+  moved_small(1);
+  moved_large(2);
+
+  REQUIRE(sum == 21);
+}
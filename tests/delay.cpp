@@ -0,0 +1,61 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+simcpp20::event<> delayed(simcpp20::simulation<> &sim, double delay, int id,
+                          std::vector<int> &order) {
+  co_await sim.delay(delay);
+  REQUIRE(sim.now() == delay);
+  order.push_back(id);
+}
+
+TEST_CASE("delay resumes in order with timeouts") {
+  simcpp20::simulation<> sim;
+  std::vector<int> order;
+
+  delayed(sim, 2, 0, order);
+  sim.timeout(2).add_callback([&order](const auto &) { order.push_back(1); });
+  delayed(sim, 1, 2, order);
+
+  sim.run();
+
+  // the timeout is scheduled before the processes start
+  REQUIRE(order == std::vector<int>{2, 1, 0});
+}
+
+TEST_CASE("delay can be converted to a timeout") {
+  simcpp20::simulation<> sim;
+
+  simcpp20::event<> ev = sim.delay(3);
+  sim.run();
+
+  REQUIRE(ev.processed());
+  REQUIRE(sim.now() == 3);
+}
+
+struct destruction_flag {
+  ~destruction_flag() { destroyed = true; }
+  bool &destroyed;
+};
+
+simcpp20::event<> sleeper(simcpp20::simulation<> &sim, bool &destroyed) {
+  destruction_flag flag{destroyed};
+  co_await sim.delay(10);
+}
+
+TEST_CASE("delayed coroutines are destroyed with the simulation") {
+  bool destroyed = false;
+
+  {
+    simcpp20::simulation<> sim;
+    sleeper(sim, destroyed);
+    sim.run_until(5);
+    REQUIRE(!destroyed);
+  }
+
+  REQUIRE(destroyed);
+}
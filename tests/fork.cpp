@@ -0,0 +1,61 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <cstddef>
+#include <stdexcept>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+#include "fschuetz04/simcpp20.hpp"
+#include "fschuetz04/simcpp20/fork.hpp"
+
+simcpp20::event<> ticks(simcpp20::simulation<> &sim, double delay, int &n) {
+  while (true) {
+    co_await sim.timeout(delay);
+    ++n;
+  }
+}
+
+TEST_CASE("variants continue from the state of the parent") {
+  simcpp20::simulation<> sim;
+  int n = 0;
+  ticks(sim, 1, n);
+  sim.run_until(10.5);
+  REQUIRE(n == 10);
+
+  auto results = simcpp20::fork_variants(
+      6,
+      [&](std::size_t i) {
+        // variant i adds a second process ticking every i + 1
+        int m = 0;
+        ticks(sim, static_cast<double>(i + 1), m);
+        sim.run_until(20.5);
+        return n * 100 + m;
+      },
+      GENERATE(1, 4, 0));
+
+  REQUIRE(results.size() == 6);
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    int m = static_cast<int>(9 / (i + 1));
+    REQUIRE(results[i] == 20 * 100 + m);
+  }
+
+  // the parent is not affected by the variants
+  REQUIRE(sim.now() == 10.5);
+  REQUIRE(n == 10);
+  sim.run_until(12.5);
+  REQUIRE(n == 12);
+}
+
+TEST_CASE("failing variants throw in the parent") {
+  auto variant = [](std::size_t i) {
+    if (i == 2) {
+      throw std::runtime_error{"variant failed"};
+    }
+    return i;
+  };
+
+  REQUIRE_THROWS_AS(simcpp20::fork_variants(5, variant, 2),
+                    std::runtime_error);
+  REQUIRE(simcpp20::fork_variants(0, variant).empty());
+}
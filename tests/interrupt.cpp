@@ -0,0 +1,137 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <any>
+#include <vector>
+
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+struct int_cause_policy : simcpp20::default_policy {
+  using interrupt_cause = int;
+};
+
+struct int_cause_transfer_policy : int_cause_policy {
+  static constexpr bool symmetric_transfer = true;
+};
+
+template <typename Policy>
+simcpp20::process<double, Policy>
+sleeper(simcpp20::simulation<double, Policy> &sim, std::vector<int> &causes) {
+  while (true) {
+    auto result = co_await sim.timeout(10);
+    if (!result) {
+      causes.push_back(result.cause());
+      continue;
+    }
+
+    causes.push_back(-static_cast<int>(sim.now()));
+    co_return;
+  }
+}
+
+TEMPLATE_TEST_CASE("interrupts are returned by co_await", "", int_cause_policy,
+                   int_cause_transfer_policy) {
+  simcpp20::simulation<double, TestType> sim;
+  std::vector<int> causes;
+
+  auto proc = sleeper(sim, causes);
+  sim.timeout(3).add_callback([proc](const auto &) { proc.interrupt(1); });
+  sim.timeout(5).add_callback([proc](const auto &) {
+    // both are delivered, one per co_await
+    proc.interrupt(2);
+    proc.interrupt(3);
+  });
+
+  sim.run();
+
+  REQUIRE(causes == std::vector<int>{1, 2, 3, -15});
+  REQUIRE(proc.processed());
+
+  // interrupting a returned process does nothing
+  proc.interrupt(4);
+  sim.run();
+  REQUIRE(causes.size() == 4);
+}
+
+simcpp20::process<> value_waiter(simcpp20::simulation<> &sim,
+                                 simcpp20::value_event<int> ev,
+                                 std::vector<int> &values) {
+  auto first = co_await ev;
+  REQUIRE(first.interrupted());
+  REQUIRE(std::any_cast<int>(first.cause()) == 7);
+
+  auto second = co_await ev;
+  REQUIRE(!second.interrupted());
+  values.push_back(*second);
+
+  // a delay is awaited as a timeout
+  auto third = co_await sim.delay(2);
+  REQUIRE(!third.interrupted());
+  values.push_back(static_cast<int>(sim.now()));
+}
+
+TEST_CASE("interrupted processes can await the same event again") {
+  simcpp20::simulation<> sim;
+  std::vector<int> values;
+
+  auto ev = sim.event<int>();
+  auto proc = value_waiter(sim, ev, values);
+
+  // pending until the process started
+  proc.interrupt(7);
+  sim.timeout(4).add_callback([ev](const auto &) { ev.trigger(42); });
+
+  sim.run();
+
+  REQUIRE(values == std::vector<int>{42, 6});
+  REQUIRE(proc.processed());
+}
+
+simcpp20::event<> aborted_waiter(simcpp20::simulation<> &sim, bool &resumed) {
+  co_await sim.timeout(1);
+  resumed = true;
+}
+
+TEST_CASE("coroutines of aborted events are not resumed") {
+  simcpp20::simulation<> sim;
+  bool resumed = false;
+
+  auto proc = aborted_waiter(sim, resumed);
+  sim.run_until(0.5);
+  proc.abort();
+
+  sim.run();
+
+  REQUIRE(!resumed);
+  REQUIRE(proc.aborted());
+}
+
+simcpp20::process<> preempted_user(simcpp20::simulation<> &sim,
+                                   simcpp20::preemptive_resource<> &res,
+                                   simcpp20::process<> &self,
+                                   std::vector<double> &log) {
+  co_await res.request(self, 1);
+  auto result = co_await sim.timeout(10);
+  REQUIRE(result.interrupted());
+
+  using preemption = simcpp20::preemptive_resource<>::preemption;
+  auto &cause = std::any_cast<preemption &>(result.cause());
+  log.push_back(cause.usage_since_);
+  log.push_back(sim.now());
+}
+
+TEST_CASE("preempted processes are interrupted") {
+  simcpp20::simulation<> sim;
+  simcpp20::preemptive_resource<> res{sim, 1};
+  std::vector<double> log;
+
+  simcpp20::process<> self{sim};
+  self = preempted_user(sim, res, self, log);
+  sim.timeout(3).add_callback([&res](const auto &) { res.request(0); });
+
+  sim.run();
+
+  REQUIRE(log == std::vector<double>{0, 3});
+}
@@ -0,0 +1,165 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <cmath>
+#include <random>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+TEST_CASE("tallies compute mean and variance incrementally") {
+  simcpp20::tally t;
+  REQUIRE(t.count() == 0);
+  REQUIRE(t.mean() == 0);
+  REQUIRE(t.variance() == 0);
+
+  for (double x : {2, 4, 4, 4, 5, 5, 7, 9}) {
+    t.add(x);
+  }
+
+  REQUIRE(t.count() == 8);
+  REQUIRE(t.mean() == 5);
+  REQUIRE(std::abs(t.variance() - 32. / 7) < 1e-12);
+  REQUIRE(t.min() == 2);
+  REQUIRE(t.max() == 9);
+
+  t.reset();
+  REQUIRE(t.count() == 0);
+}
+
+TEST_CASE("time-weighted monitors weight values by time") {
+  simcpp20::simulation<> sim;
+  simcpp20::time_weighted<> level{sim, 1};
+
+  sim.timeout(2).add_callback([&](const auto &) { level.set(3); });
+  sim.timeout(3).add_callback([&](const auto &) { level.add(-3); });
+  sim.run_until(4);
+
+  // 1 for 2, 3 for 1 and 0 for 1
+  REQUIRE(level.duration() == 4);
+  REQUIRE(level.mean() == 5. / 4);
+  REQUIRE(level.variance() == (2. + 9.) / 4 - 25. / 16);
+  REQUIRE(level.min() == 0);
+  REQUIRE(level.max() == 3);
+
+  level.reset();
+  sim.run_until(6);
+  REQUIRE(level.duration() == 2);
+  REQUIRE(level.mean() == 0);
+}
+
+TEST_CASE("histograms count observations per bin") {
+  simcpp20::histogram h{0, 10, 5};
+  for (double x : {-1., 0., 1.9, 2., 9.99, 10., 3.}) {
+    h.add(x);
+  }
+  h.add(4, 2.5);
+
+  REQUIRE(h.size() == 5);
+  REQUIRE(h[0] == 2);
+  REQUIRE(h[1] == 2);
+  REQUIRE(h[2] == 2.5);
+  REQUIRE(h[4] == 1);
+  REQUIRE(h.underflow() == 1);
+  REQUIRE(h.overflow() == 1);
+  REQUIRE(h.total() == 9.5);
+  REQUIRE(h.lower_bound(3) == 6);
+
+  h.reset();
+  REQUIRE(h.total() == 0);
+  REQUIRE(h[1] == 0);
+}
+
+TEST_CASE("p2 quantiles estimate quantiles of streams") {
+  simcpp20::p2_quantile median{0.5};
+  simcpp20::p2_quantile p90{0.9};
+  REQUIRE(median.value() == 0);
+
+  median.add(3);
+  median.add(1);
+  median.add(2);
+  REQUIRE(median.value() == 2);
+
+  std::default_random_engine gen{42};
+  std::exponential_distribution<> dist{1};
+  for (int i = 0; i < 100'000; ++i) {
+    double x = dist(gen);
+    median.add(x);
+    p90.add(x);
+  }
+
+  REQUIRE(median.count() == 100'003);
+  REQUIRE(std::abs(median.value() - std::log(2.)) < 0.02);
+  REQUIRE(std::abs(p90.value() - std::log(10.)) < 0.05);
+}
+
+simcpp20::event<> user(simcpp20::simulation<> &sim,
+                       simcpp20::resource<> &res, double patience) {
+  auto request = res.request();
+  co_await (request | sim.timeout(patience));
+  if (!request.triggered()) {
+    request.abort();
+    co_return;
+  }
+
+  co_await sim.timeout(2);
+  res.release();
+}
+
+TEST_CASE("resources record their queue and usage") {
+  simcpp20::simulation<> sim;
+  simcpp20::resource<> res{sim, 1};
+  simcpp20::time_weighted<> queued{sim};
+  simcpp20::time_weighted<> in_use{sim};
+  res.monitor(&queued, &in_use);
+
+  // the second user waits 2, the third reneges after 1
+  user(sim, res, 10);
+  user(sim, res, 10);
+  user(sim, res, 1);
+  sim.run_until(4);
+
+  REQUIRE(in_use.mean() == 1);
+  REQUIRE(queued.mean() == (2 * 1 + 1 * 1) / 4.);
+  REQUIRE(queued.max() == 2);
+}
+
+TEST_CASE("preemptive resources record their queue and usage") {
+  simcpp20::simulation<> sim;
+  simcpp20::preemptive_resource<> res{sim, 1};
+  simcpp20::time_weighted<> queued{sim};
+  simcpp20::time_weighted<> in_use{sim};
+  res.monitor(&queued, &in_use);
+
+  // the second request waits 2, the third is aborted after 1
+  auto first = res.request(1);
+  res.request(1, false);
+  auto third = res.request(2, false);
+  sim.timeout(1).add_callback([&](const auto &) { third.abort(); });
+  sim.timeout(2).add_callback([&](const auto &) { res.release(first); });
+  sim.run_until(4);
+
+  REQUIRE(in_use.mean() == 1);
+  REQUIRE(queued.mean() == (2 * 1 + 1 * 1) / 4.);
+  REQUIRE(queued.max() == 2);
+}
+
+TEST_CASE("containers and stores record their level") {
+  simcpp20::simulation<> sim;
+  simcpp20::container<> tank{sim, 10, 4};
+  simcpp20::store<int> box{sim};
+  simcpp20::time_weighted<> level{sim};
+  simcpp20::time_weighted<> size{sim};
+  tank.monitor(&level);
+  box.monitor(&size);
+
+  box.put(1);
+  sim.timeout(1).add_callback([&](const auto &) {
+    tank.get(4);
+    box.get();
+  });
+  sim.run_until(2);
+
+  REQUIRE(level.mean() == 2);
+  REQUIRE(size.mean() == 0.5);
+}
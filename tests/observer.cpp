@@ -0,0 +1,77 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+struct counting_observer_policy : simcpp20::default_policy {
+  using observer = simcpp20::counting_observer;
+};
+
+template <typename Policy>
+simcpp20::event<double, Policy>
+waiter(simcpp20::simulation<double, Policy> &sim) {
+  co_await sim.timeout(1);
+  co_await sim.delay(1);
+}
+
+TEST_CASE("counting observer counts all hooks") {
+  simcpp20::simulation<double, counting_observer_policy> sim;
+
+  auto proc = waiter(sim);
+  proc.add_callback([](const auto &) {});
+  sim.timeout(5).abort();
+
+  sim.run();
+
+  auto &counts = sim.observer();
+  // start of the process, timeout, delay, process event, aborted timeout,
+  // where only the timeout and the process event are processed as events and
+  // the aborted timeout is skipped without a step
+  REQUIRE(counts.scheduled_ == 5);
+  REQUIRE(counts.steps_ == 4);
+  REQUIRE(counts.processed_ == 2);
+  REQUIRE(counts.triggered_ == 1);
+  REQUIRE(counts.aborted_ == 1);
+  // resumed at its start, after the timeout and after the delay
+  REQUIRE(counts.resumed_ == 3);
+  REQUIRE(counts.callbacks_ == 1);
+
+  // the aborted timeout stays in the event queue until it is skipped last
+  REQUIRE(counts.max_queue_size_ == 1);
+  REQUIRE(counts.queue_sizes_[0] == 0);
+  REQUIRE(counts.queue_sizes_[1] == 4);
+}
+
+struct trace_policy : simcpp20::default_policy {
+  using observer = simcpp20::trace_observer<simcpp20::trace_ring<8>>;
+};
+
+TEST_CASE("trace ring keeps the most recent records") {
+  simcpp20::simulation<double, trace_policy> sim;
+  for (int i = 0; i < 3; ++i) {
+    sim.timeout(i);
+  }
+
+  sim.run();
+
+  // three schedules, then step and process per timeout
+  auto &ring = sim.observer().sink();
+  REQUIRE(ring.size() == 8);
+  REQUIRE(ring.dropped() == 1);
+
+  std::vector<simcpp20::trace_kind> kinds;
+  for (std::size_t i = 0; i < ring.size(); ++i) {
+    kinds.push_back(ring[i].kind_);
+  }
+
+  using kind = simcpp20::trace_kind;
+  REQUIRE(kinds == std::vector<kind>{kind::schedule, kind::schedule, kind::step,
+                                     kind::process, kind::step, kind::process,
+                                     kind::step, kind::process});
+  REQUIRE(ring[7].time_ == 2);
+  REQUIRE(ring[7].id_ == 2);
+  REQUIRE(ring[6].value_ == 0);
+}
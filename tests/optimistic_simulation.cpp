@@ -0,0 +1,85 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+#include "fschuetz04/simcpp20/optimistic_simulation.hpp"
+
+struct counter {
+  std::uint64_t hash = 0;
+  int n = 0;
+};
+
+using osim_type = simcpp20::optimistic_simulation<counter, int>;
+
+// forwards each message to another logical process, with varying delays so
+// messages frequently arrive in the past of their receiver
+void forward(osim_type::logical_process &lp, counter &state, const int &msg) {
+  state.hash = state.hash * 31 + static_cast<std::uint64_t>(msg) +
+               static_cast<std::uint64_t>(lp.now() * 8);
+  ++state.n;
+
+  auto to = static_cast<std::size_t>(msg * 7 + state.n) % 4;
+  lp.send(to, msg + 1, 0.125 * static_cast<double>(1 + msg % 5 + to));
+}
+
+std::vector<counter> run_forward(std::size_t batch) {
+  osim_type osim{std::vector<counter>(4), forward, batch};
+  for (int i = 0; i < 8; ++i) {
+    osim.send(static_cast<std::size_t>(i) % 4, i * 10, 0.5 * i);
+  }
+
+  osim.run_until(50);
+
+  std::vector<counter> states;
+  for (std::size_t i = 0; i < osim.size(); ++i) {
+    states.push_back(osim[i].state());
+  }
+  return states;
+}
+
+TEST_CASE("optimistic runs match sequential runs") {
+  // with one message per round, logical processes rarely run ahead
+  auto expected = run_forward(1);
+
+  int n = 0;
+  for (auto &state : expected) {
+    n += state.n;
+  }
+  REQUIRE(n > 500);
+
+  for (std::size_t batch : {16, 64, 256, 256, 256}) {
+    auto states = run_forward(batch);
+    for (std::size_t j = 0; j < states.size(); ++j) {
+      REQUIRE(states[j].hash == expected[j].hash);
+      REQUIRE(states[j].n == expected[j].n);
+    }
+  }
+}
+
+TEST_CASE("optimistic simulations continue after run_until") {
+  std::vector<double> times;
+  simcpp20::optimistic_simulation<int, int> osim{
+      std::vector<int>(1),
+      [&times](auto &lp, int &state, const int &msg) {
+        times.push_back(lp.now());
+        state += msg;
+        if (msg > 0) {
+          lp.send(0, msg - 1, 2);
+        }
+      }};
+
+  osim.send(0, 3, 1);
+  osim.run_until(4);
+  REQUIRE(times == std::vector<double>{1, 3});
+  REQUIRE(osim[0].state() == 5);
+
+  osim.run_until(100);
+  REQUIRE(times == std::vector<double>{1, 3, 5, 7});
+  REQUIRE(osim[0].state() == 6);
+  REQUIRE(osim[0].rollbacks() == 0);
+}
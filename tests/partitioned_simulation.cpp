@@ -0,0 +1,90 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+#include "fschuetz04/simcpp20/partitioned_simulation.hpp"
+
+using psim_type = simcpp20::partitioned_simulation<int>;
+using log_type = std::vector<std::pair<double, int>>;
+
+simcpp20::event<> pinger(psim_type::logical_process &lp, log_type &log) {
+  for (int i = 0; i < 5; ++i) {
+    lp.send(1, i, 1.5);
+    int reply = co_await lp.receive();
+    log.emplace_back(lp.sim.now(), reply);
+  }
+}
+
+simcpp20::event<> ponger(psim_type::logical_process &lp) {
+  while (true) {
+    int msg = co_await lp.receive();
+    co_await lp.sim.timeout(0.25);
+    lp.send(0, -msg, 1);
+  }
+}
+
+TEST_CASE("logical processes exchange messages") {
+  psim_type psim{2, 1};
+  log_type log;
+
+  pinger(psim[0], log);
+  ponger(psim[1]);
+
+  psim.run_until(100);
+
+  REQUIRE(log == log_type{{2.75, 0},
+                          {5.5, -1},
+                          {8.25, -2},
+                          {11, -3},
+                          {13.75, -4}});
+  REQUIRE(psim[0].sim.now() == 100);
+  REQUIRE(psim[1].sim.now() == 100);
+}
+
+simcpp20::event<> station(psim_type::logical_process &lp, std::size_t next,
+                          std::vector<int> &visits) {
+  while (true) {
+    int token = co_await lp.receive();
+    visits.push_back(token);
+    co_await lp.sim.timeout(0.5);
+    lp.send(next, token + 1, 2);
+  }
+}
+
+TEST_CASE("partitioned simulations are deterministic") {
+  auto run = [](double target) {
+    std::size_t n = 8;
+    psim_type psim{n, 2};
+    std::vector<std::vector<int>> visits(n);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      station(psim[i], (i + 1) % n, visits[i]);
+    }
+
+    // several tokens in transit at once
+    for (std::size_t i = 0; i < n; i += 2) {
+      psim[i].send(i, static_cast<int>(100 * i), 2);
+    }
+
+    psim.run_until(target);
+    return visits;
+  };
+
+  auto visits = run(50);
+
+  // each token takes 2.5 time units per station, so each station receives
+  // one of the four tokens every 5 time units
+  for (auto &station_visits : visits) {
+    REQUIRE(station_visits.size() == 10);
+  }
+  REQUIRE(std::vector<int>(visits[1].begin(), visits[1].begin() + 5) ==
+          std::vector<int>{1, 603, 405, 207, 9});
+
+  for (int i = 0; i < 5; ++i) {
+    REQUIRE(run(50) == visits);
+  }
+}
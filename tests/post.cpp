@@ -0,0 +1,93 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <thread>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+simcpp20::event<> consumer(simcpp20::simulation<> &, simcpp20::store<int> &feed,
+                           int n, std::vector<int> &received) {
+  for (int i = 0; i < n; ++i) {
+    received.push_back(co_await feed.get());
+  }
+}
+
+simcpp20::event<> ticker(simcpp20::simulation<> &sim, simcpp20::event<> done) {
+  while (!done.processed()) {
+    co_await sim.timeout(1);
+  }
+}
+
+TEST_CASE("functions are posted from other threads") {
+  simcpp20::simulation<> sim;
+  simcpp20::store<int> feed{sim};
+  std::vector<int> received;
+
+  int n_threads = 4;
+  int n_values = 1000;
+  auto done = consumer(sim, feed, n_threads * n_values, received);
+  ticker(sim, done);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&sim, &feed, t, n_values] {
+      for (int i = 0; i < n_values; ++i) {
+        int value = t * n_values + i;
+        sim.post([&feed, value](auto &) { feed.put(value); });
+      }
+    });
+  }
+
+  sim.run();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE(received.size() == 4000);
+
+  // values posted by the same thread are received in order
+  std::vector<int> last(4, -1);
+  for (int value : received) {
+    auto t = static_cast<std::size_t>(value / n_values);
+    REQUIRE(value > last[t]);
+    last[t] = value;
+  }
+}
+
+TEST_CASE("posted functions run at the current time") {
+  simcpp20::simulation<> sim;
+  std::vector<double> times;
+
+  sim.timeout(5);
+  sim.run_until(2);
+
+  sim.post([&times](auto &sim) { times.push_back(sim.now()); });
+  REQUIRE(times.empty());
+
+  sim.poll();
+  REQUIRE(times == std::vector<double>{2});
+
+  // pending functions are destroyed with the simulation
+  sim.post([&times](auto &) { times.push_back(-1); });
+}
+
+TEST_CASE("posted functions may abort all scheduled events") {
+  simcpp20::simulation<> sim;
+  std::vector<simcpp20::event<>> timeouts;
+  for (int i = 0; i < 64; ++i) {
+    timeouts.push_back(sim.timeout(1));
+  }
+
+  // aborting all timeouts compacts the event queue, so it is empty afterwards
+  sim.post([&timeouts](auto &) {
+    for (auto &timeout : timeouts) {
+      timeout.abort();
+    }
+  });
+  sim.run();
+
+  REQUIRE(sim.empty());
+  REQUIRE(sim.now() == 0);
+}
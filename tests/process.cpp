@@ -0,0 +1,92 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <vector>
+
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+struct eager_policy : simcpp20::default_policy {
+  static constexpr bool eager_start = true;
+};
+
+struct transfer_policy : simcpp20::default_policy {
+  static constexpr bool symmetric_transfer = true;
+};
+
+struct eager_transfer_policy : simcpp20::default_policy {
+  static constexpr bool eager_start = true;
+  static constexpr bool symmetric_transfer = true;
+};
+
+template <typename Policy>
+simcpp20::event<double, Policy> starter(simcpp20::simulation<double, Policy> &,
+                                        bool &started) {
+  started = true;
+  co_return;
+}
+
+TEST_CASE("processes start at the current time unless the start is eager") {
+  SECTION("default") {
+    simcpp20::simulation<> sim;
+    bool started = false;
+    starter(sim, started);
+    REQUIRE(!started);
+
+    sim.run();
+
+    REQUIRE(started);
+  }
+
+  SECTION("eager") {
+    simcpp20::simulation<double, eager_policy> sim;
+    bool started = false;
+    auto ev = starter(sim, started);
+    REQUIRE(started);
+
+    sim.run();
+
+    REQUIRE(ev.processed());
+  }
+}
+
+template <typename Policy>
+simcpp20::value_event<int, double, Policy>
+child(simcpp20::simulation<double, Policy> &sim, int depth) {
+  if (depth == 0) {
+    co_await sim.timeout(1);
+    co_return 0;
+  }
+
+  auto value = co_await child(sim, depth - 1);
+  co_return value + 1;
+}
+
+template <typename Policy>
+simcpp20::event<double, Policy>
+parent(simcpp20::simulation<double, Policy> &sim, std::vector<int> &order) {
+  auto value = co_await child(sim, 100);
+  REQUIRE(value == 100);
+  REQUIRE(sim.now() == 1);
+  order.push_back(0);
+}
+
+TEMPLATE_TEST_CASE("nested processes return their values", "",
+                   simcpp20::default_policy, eager_policy, transfer_policy,
+                   eager_transfer_policy) {
+  simcpp20::simulation<double, TestType> sim;
+  std::vector<int> order;
+  parent(sim, order);
+  sim.timeout(1).add_callback([&order](const auto &) { order.push_back(1); });
+
+  sim.run();
+
+  if constexpr (TestType::eager_start && TestType::symmetric_transfer) {
+    // the innermost timeout is scheduled first, and the chain of returning
+    // processes does not pass through the scheduler
+    REQUIRE(order == std::vector<int>{0, 1});
+  } else {
+    REQUIRE(order == std::vector<int>{1, 0});
+  }
+}
@@ -0,0 +1,383 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+struct item {
+  double time_;
+  std::uint64_t id_;
+
+  bool operator>(const item &other) const {
+    if (time_ != other.time_) {
+      return time_ > other.time_;
+    }
+
+    return id_ > other.id_;
+  }
+};
+
+template <typename Item> using four_ary_heap = simcpp20::d_ary_heap<Item, 4>;
+template <typename Item> using two_ary_heap = simcpp20::d_ary_heap<Item, 2>;
+
+TEMPLATE_TEST_CASE("event queues order by time and insertion", "",
+                   simcpp20::binary_heap<item>, four_ary_heap<item>,
+                   two_ary_heap<item>, simcpp20::calendar_queue<item>) {
+  TestType queue;
+  std::default_random_engine gen{42};
+  std::uniform_int_distribution<> delay_dist{0, 20};
+  std::uint64_t next_id = 0;
+  double now = 0;
+
+  // interleave pushes and pops, so the queue grows and shrinks repeatedly
+  for (int round = 0; round < 200; ++round) {
+    int n_push = round % 7 == 0 ? 50 : 3;
+    for (int i = 0; i < n_push; ++i) {
+      queue.push(item{now + delay_dist(gen) / 4.0, next_id++});
+    }
+
+    int n_pop = round % 5 == 0 ? 40 : 2;
+    for (int i = 0; i < n_pop && !queue.empty(); ++i) {
+      auto next = queue.top();
+      queue.pop();
+      REQUIRE(next.time_ >= now);
+      now = next.time_;
+    }
+  }
+
+  item last{now, 0};
+  bool first = true;
+  while (!queue.empty()) {
+    auto next = queue.top();
+    queue.pop();
+    if (!first) {
+      REQUIRE(next > last);
+    }
+
+    last = next;
+    first = false;
+  }
+
+  REQUIRE(queue.size() == 0);
+}
+
+struct calendar_policy : simcpp20::default_policy {
+  template <typename Item> using queue = simcpp20::calendar_queue<Item>;
+};
+
+struct d_ary_policy : simcpp20::default_policy {
+  template <typename Item> using queue = simcpp20::d_ary_heap<Item>;
+};
+
+TEMPLATE_TEST_CASE("simulation uses the event queue of the policy", "",
+                   simcpp20::default_policy, calendar_policy, d_ary_policy) {
+  simcpp20::simulation<double, TestType> sim;
+  std::vector<int> order;
+
+  for (int i = 0; i < 6; ++i) {
+    auto ev = sim.timeout(i % 3);
+    ev.add_callback([&order, i](const auto &) { order.push_back(i); });
+  }
+
+  sim.run();
+
+  REQUIRE(order == std::vector<int>{0, 3, 1, 4, 2, 5});
+  REQUIRE(sim.now() == 2);
+}
+
+TEMPLATE_TEST_CASE("batches keep the order of the range", "",
+                   simcpp20::default_policy, calendar_policy, d_ary_policy) {
+  simcpp20::simulation<double, TestType> sim;
+  std::vector<int> order;
+
+  // events scheduled before the batch, so small batches are inserted one by
+  // one and large batches rebuild the heap
+  std::vector<simcpp20::event<double, TestType>> before;
+  for (int i = 0; i < 20; ++i) {
+    before.push_back(sim.timeout(10));
+  }
+
+  auto first = sim.timeout(1);
+  first.add_callback([&order](const auto &) { order.push_back(-1); });
+
+  std::size_t n = GENERATE(1, 200);
+  std::vector<double> delays;
+  for (std::size_t i = 0; i < n; ++i) {
+    delays.push_back(static_cast<double>(i % 4));
+  }
+
+  auto evs = sim.timeout_batch(delays);
+  REQUIRE(evs.size() == n);
+  for (std::size_t i = 0; i < n; ++i) {
+    evs[i].add_callback([&order, i](const auto &) {
+      order.push_back(static_cast<int>(i));
+    });
+  }
+
+  sim.run();
+
+  std::vector<int> expected;
+  for (std::size_t delay = 0; delay < 4; ++delay) {
+    if (delay == 1) {
+      expected.push_back(-1);
+    }
+
+    for (std::size_t i = delay; i < n; i += 4) {
+      expected.push_back(static_cast<int>(i));
+    }
+  }
+
+  REQUIRE(order == expected);
+}
+
+TEMPLATE_TEST_CASE("events at the current time keep the insertion order", "",
+                   simcpp20::default_policy, calendar_policy, d_ary_policy) {
+  simcpp20::simulation<double, TestType> sim;
+  std::vector<int> order;
+
+  // both scheduled before time 1 is reached
+  auto a = sim.timeout(1);
+  auto b = sim.timeout(1);
+
+  a.add_callback([&](const auto &) {
+    order.push_back(0);
+
+    // scheduled at time 1, so processed after b
+    auto c = sim.timeout(0);
+    c.add_callback([&](const auto &) {
+      order.push_back(2);
+
+      auto d = sim.event();
+      d.add_callback([&](const auto &) { order.push_back(4); });
+      d.trigger();
+    });
+
+    auto e = sim.event();
+    e.add_callback([&](const auto &) { order.push_back(3); });
+    e.trigger();
+  });
+  b.add_callback([&](const auto &) { order.push_back(1); });
+
+  auto f = sim.timeout(2);
+  f.add_callback([&](const auto &) { order.push_back(5); });
+
+  sim.run_until(1.5);
+  REQUIRE(order == std::vector<int>{0, 1, 2, 3, 4});
+  REQUIRE(sim.now() == 1.5);
+
+  sim.run();
+  REQUIRE(order == std::vector<int>{0, 1, 2, 3, 4, 5});
+  REQUIRE(sim.empty());
+}
+
+TEMPLATE_TEST_CASE("event queues remove items by predicate", "",
+                   simcpp20::binary_heap<item>, four_ary_heap<item>,
+                   simcpp20::calendar_queue<item>) {
+  TestType queue;
+  std::default_random_engine gen{42};
+  std::uniform_int_distribution<> delay_dist{0, 100};
+
+  for (std::uint64_t id = 0; id < 500; ++id) {
+    queue.push(item{delay_dist(gen) / 4.0, id});
+  }
+
+  auto n = queue.remove_if([](const item &it) { return it.id_ % 3 != 0; });
+  REQUIRE(n == 333);
+  REQUIRE(queue.size() == 167);
+
+  item last{0, 0};
+  while (!queue.empty()) {
+    auto next = queue.top();
+    queue.pop();
+    REQUIRE(next.id_ % 3 == 0);
+    REQUIRE((next > last || next.id_ == 0));
+    last = next;
+  }
+}
+
+// size of the last constructed observed_heap
+struct observed_size {
+  static inline std::size_t (*get)(const void *) = nullptr;
+  static inline const void *instance = nullptr;
+};
+
+// binary heap remembering the last instance, optionally without remove_if
+template <typename Item, bool Remove>
+class observed_heap : public simcpp20::binary_heap<Item> {
+public:
+  observed_heap() {
+    observed_size::instance = this;
+    observed_size::get = [](const void *heap) {
+      return static_cast<const observed_heap *>(heap)->size();
+    };
+  }
+
+  template <typename Predicate>
+  std::size_t remove_if(Predicate pred)
+    requires Remove
+  {
+    return simcpp20::binary_heap<Item>::remove_if(pred);
+  }
+};
+
+template <bool Remove> struct observed_policy : simcpp20::default_policy {
+  template <typename Item> using queue = observed_heap<Item, Remove>;
+};
+
+TEMPLATE_TEST_CASE("aborted timeouts are removed from the event queue", "",
+                   observed_policy<true>, observed_policy<false>) {
+  simcpp20::simulation<double, TestType> sim;
+  std::vector<int> order;
+
+  std::vector<simcpp20::event<double, TestType>> evs;
+  for (int i = 0; i < 1000; ++i) {
+    evs.push_back(sim.timeout(1000 - i));
+    evs.back().add_callback([&order, i](const auto &) { order.push_back(i); });
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    if (i % 10 != 0) {
+      evs[static_cast<std::size_t>(i)].abort();
+    }
+  }
+
+  // compacted once more than half of the entries were dead
+  REQUIRE(observed_size::get(observed_size::instance) < 600);
+
+  sim.run();
+
+  std::vector<int> expected;
+  for (int i = 990; i >= 0; i -= 10) {
+    expected.push_back(i);
+  }
+
+  REQUIRE(order == expected);
+  REQUIRE(sim.now() == 1000);
+}
+
+TEST_CASE("aborted timeouts do not advance the current time") {
+  // only the larger number of aborted timeouts triggers a compaction
+  auto n = GENERATE(1, 100);
+
+  simcpp20::simulation<> sim;
+  sim.timeout(1);
+  for (int i = 0; i < n; ++i) {
+    sim.timeout(10 + i).abort();
+  }
+
+  sim.run();
+
+  REQUIRE(sim.now() == 1);
+  REQUIRE(sim.empty());
+}
+
+TEST_CASE("events may be scheduled before skipped aborted events") {
+  simcpp20::simulation<std::uint64_t> sim;
+  std::vector<std::uint64_t> times;
+  auto record = [&](const auto &) { times.push_back(sim.now()); };
+
+  sim.timeout(8).abort();
+  sim.timeout(12).add_callback(record);
+
+  // skips the aborted timeout without advancing the clock
+  sim.step();
+  REQUIRE(sim.now() == 0);
+
+  sim.timeout(7).add_callback(record);
+  sim.timeout(0).add_callback(record);
+  sim.run();
+
+  REQUIRE(times == std::vector<std::uint64_t>{0, 7, 12});
+  REQUIRE(sim.now() == 12);
+}
+
+struct tick_item {
+  std::uint64_t time_;
+  std::uint64_t id_;
+
+  bool operator>(const tick_item &other) const {
+    if (time_ != other.time_) {
+      return time_ > other.time_;
+    }
+
+    return id_ > other.id_;
+  }
+};
+
+TEST_CASE("radix heaps order integral times by time and insertion") {
+  simcpp20::radix_heap<tick_item> queue;
+  simcpp20::binary_heap<tick_item> expected;
+  std::default_random_engine gen{42};
+  std::uniform_int_distribution<std::uint64_t> delay_dist{0, 1000};
+  std::uint64_t next_id = 0;
+  std::uint64_t now = 0;
+
+  // pushes are monotone, as in a simulation
+  for (int round = 0; round < 300; ++round) {
+    int n_push = round % 7 == 0 ? 50 : 3;
+    for (int i = 0; i < n_push; ++i) {
+      auto delay = round % 3 == 0 ? delay_dist(gen) << 40 : delay_dist(gen);
+      tick_item item{now + delay / (i % 4 + 1), next_id++};
+      queue.push(item);
+      expected.push(item);
+    }
+
+    if (round % 11 == 0) {
+      auto odd = [](const tick_item &item) { return item.id_ % 2 == 1; };
+      REQUIRE(queue.remove_if(odd) == expected.remove_if(odd));
+    }
+
+    int n_pop = round % 5 == 0 ? 40 : 2;
+    for (int i = 0; i < n_pop && !queue.empty(); ++i) {
+      REQUIRE(queue.size() == expected.size());
+      REQUIRE(queue.top().id_ == expected.top().id_);
+      now = queue.top().time_;
+      queue.pop();
+      expected.pop();
+    }
+  }
+
+  while (!queue.empty()) {
+    REQUIRE(queue.top().id_ == expected.top().id_);
+    queue.pop();
+    expected.pop();
+  }
+
+  REQUIRE(expected.empty());
+}
+
+simcpp20::event<std::uint64_t>
+ticker(simcpp20::simulation<std::uint64_t> &sim, std::uint64_t delay,
+       std::vector<std::uint64_t> &order) {
+  for (int i = 0; i < 3; ++i) {
+    co_await sim.timeout(delay);
+    order.push_back(delay);
+  }
+}
+
+TEST_CASE("simulations with integral time use a radix heap") {
+  using queue_type = simcpp20::default_policy::queue<tick_item>;
+  STATIC_REQUIRE(std::is_same_v<queue_type, simcpp20::radix_heap<tick_item>>);
+  STATIC_REQUIRE(std::is_same_v<simcpp20::default_policy::queue<item>,
+                                simcpp20::binary_heap<item>>);
+
+  simcpp20::simulation<std::uint64_t> sim;
+  std::vector<std::uint64_t> order;
+  ticker(sim, 3, order);
+  ticker(sim, 2, order);
+  auto patience = sim.timeout(5);
+  sim.timeout(4).add_callback([&](const auto &) { patience.abort(); });
+  sim.run();
+
+  // at time 6, the second timeout of the first ticker was scheduled first
+  REQUIRE(order == std::vector<std::uint64_t>{2, 3, 2, 3, 2, 3});
+  REQUIRE(sim.now() == 9);
+  REQUIRE(patience.aborted());
+}
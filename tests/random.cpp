@@ -0,0 +1,134 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20/random.hpp"
+
+TEST_CASE("philox matches the known answers") {
+  using block = simcpp20::philox::block;
+
+  STATIC_REQUIRE(simcpp20::philox::generate({0, 0, 0, 0}, {0, 0}) ==
+                 block{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+  REQUIRE(simcpp20::philox::generate(
+              {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+              {0xffffffff, 0xffffffff}) ==
+          block{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+  REQUIRE(simcpp20::philox::generate(
+              {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+              {0xa4093822, 0x299f31d0}) ==
+          block{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+
+  // the vectorized kernel computes the same blocks
+  std::array<std::array<std::uint32_t, 8>, 4> words{};
+  for (std::uint32_t j = 0; j < 8; ++j) {
+    words[0][j] = j;
+    words[2][j] = 7;
+  }
+
+  simcpp20::philox::generate_n(words, 8, {1, 2});
+  for (std::uint32_t j = 0; j < 8; ++j) {
+    auto expected = simcpp20::philox::generate({j, 0, 7, 0}, {1, 2});
+    REQUIRE(block{words[0][j], words[1][j], words[2][j], words[3][j]} ==
+            expected);
+  }
+}
+
+TEST_CASE("random streams are reproducible and independent") {
+  simcpp20::random_stream a{42, 1};
+  simcpp20::random_stream b{42, 1};
+  simcpp20::random_stream c{42, 2};
+  simcpp20::random_stream d{43, 1};
+
+  std::vector<double> xs(300);
+  std::vector<double> ys(300);
+  std::vector<double> zs(300);
+  std::vector<double> ws(300);
+  a.fill_uniform(xs);
+  b.fill_uniform({ys.data(), 100});
+  b.fill_uniform({ys.data() + 100, 200});
+  c.fill_uniform(zs);
+  d.fill_uniform(ws);
+
+  // fills of even sizes continue each other
+  REQUIRE(xs == ys);
+  REQUIRE(xs != zs);
+  REQUIRE(xs != ws);
+
+  for (auto x : xs) {
+    REQUIRE(x >= 0);
+    REQUIRE(x < 1);
+  }
+
+  // usable with the distributions of the standard library
+  std::uniform_int_distribution<> dist{1, 6};
+  for (int i = 0; i < 100; ++i) {
+    int x = dist(a);
+    REQUIRE(x >= 1);
+    REQUIRE(x <= 6);
+  }
+}
+
+double mean(const std::vector<double> &xs) {
+  double sum = 0;
+  for (auto x : xs) {
+    sum += x;
+  }
+
+  return sum / static_cast<double>(xs.size());
+}
+
+double variance(const std::vector<double> &xs) {
+  double m = mean(xs);
+  double sum = 0;
+  for (auto x : xs) {
+    sum += (x - m) * (x - m);
+  }
+
+  return sum / static_cast<double>(xs.size() - 1);
+}
+
+TEST_CASE("random streams fill spans with variates") {
+  simcpp20::random_stream rng{7};
+  std::vector<double> xs(100'001);
+
+  rng.fill_uniform(xs, 2, 4);
+  REQUIRE(std::abs(mean(xs) - 3) < 0.01);
+  REQUIRE(std::abs(variance(xs) - 4. / 12) < 0.01);
+
+  rng.fill_exponential(xs, 0.5);
+  REQUIRE(std::abs(mean(xs) - 2) < 0.03);
+  REQUIRE(std::abs(variance(xs) - 4) < 0.1);
+
+  rng.fill_normal(xs, 1, 2);
+  REQUIRE(std::abs(mean(xs) - 1) < 0.03);
+  REQUIRE(std::abs(variance(xs) - 4) < 0.1);
+
+  rng.fill_lognormal(xs, 0, 0.5);
+  REQUIRE(std::abs(mean(xs) - std::exp(0.125)) < 0.01);
+}
+
+TEST_CASE("buffered variates draw blocks from the stream") {
+  simcpp20::random_stream a{42, 3};
+  simcpp20::random_stream b{42, 3};
+  auto service_time = simcpp20::exponential_variates(a, 2);
+
+  std::vector<double> expected(256);
+  for (int round = 0; round < 3; ++round) {
+    b.fill_exponential(expected, 2);
+    for (auto x : expected) {
+      REQUIRE(service_time() == x);
+    }
+  }
+
+  auto normal = simcpp20::normal_variates(a, 5, 1);
+  auto uniform = simcpp20::uniform_variates(a, 0, 1);
+  auto lognormal = simcpp20::lognormal_variates(a);
+  REQUIRE(std::abs(normal() - 5) < 10);
+  REQUIRE(uniform() < 1);
+  REQUIRE(lognormal() > 0);
+}
@@ -0,0 +1,67 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+using namespace std::chrono_literals;
+
+TEST_CASE("run_realtime paces events against the wall clock") {
+  simcpp20::simulation<> sim;
+  std::vector<double> times;
+
+  for (double delay : {10., 20., 20., 30.}) {
+    sim.timeout(delay).add_callback(
+        [&times, &sim](const auto &) { times.push_back(sim.now()); });
+  }
+
+  // 1000 time units per second, so 50 time units take 50 ms
+  auto start = std::chrono::steady_clock::now();
+  auto stats = sim.run_realtime(50, 1000);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  REQUIRE(times == std::vector<double>{10, 20, 20, 30});
+  REQUIRE(stats.batches_ == 3);
+  REQUIRE(elapsed >= 50ms);
+  REQUIRE(sim.now() == 50);
+}
+
+TEST_CASE("run_realtime reports when the model falls behind") {
+  simcpp20::simulation<> sim;
+
+  sim.timeout(1).add_callback(
+      [](const auto &) { std::this_thread::sleep_for(30ms); });
+  sim.timeout(2);
+  sim.timeout(3);
+
+  auto stats = sim.run_realtime(4, 1000);
+
+  REQUIRE(stats.batches_ == 3);
+  REQUIRE(stats.behind_ == 2);
+  REQUIRE(stats.max_lag_ >= 20ms);
+}
+
+TEST_CASE("run_realtime wakes up for posted functions") {
+  simcpp20::simulation<> sim;
+  double received = -1;
+
+  std::thread poster{[&] {
+    std::this_thread::sleep_for(20ms);
+    sim.post([&received](auto &sim) {
+      sim.timeout(0).add_callback(
+          [&received, &sim](const auto &) { received = sim.now(); });
+    });
+  }};
+
+  // without the post, the simulation would sleep for ten seconds and never
+  // call the posted function
+  sim.run_realtime(10000, 1000);
+  poster.join();
+
+  REQUIRE(received >= 20);
+  REQUIRE(received < 10000);
+}
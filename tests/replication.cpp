@@ -0,0 +1,64 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+simcpp20::event<> arrivals(simcpp20::simulation<> &sim,
+                           std::default_random_engine &gen, int &n) {
+  std::exponential_distribution<> dist{1};
+  while (true) {
+    co_await sim.timeout(dist(gen));
+    ++n;
+  }
+}
+
+int count_arrivals(simcpp20::simulation<> &sim, std::uint64_t seed) {
+  std::default_random_engine gen{static_cast<unsigned>(seed)};
+  int n = 0;
+  arrivals(sim, gen, n);
+  sim.run_until(100);
+  return n;
+}
+
+TEST_CASE("replications do not depend on the number of threads") {
+  auto expected = simcpp20::replicate(count_arrivals, 50, 7, 1);
+  REQUIRE(expected.size() == 50);
+
+  std::size_t n_threads = GENERATE(2, 8, 0);
+  auto results = simcpp20::replicate(count_arrivals, 50, 7, n_threads);
+  REQUIRE(results == expected);
+
+  // replication i uses seed 7 + i
+  simcpp20::simulation<> sim;
+  REQUIRE(results[3] == count_arrivals(sim, 10));
+
+  auto sum = simcpp20::replicate_reduce(
+      count_arrivals, 50, 0, [](int a, int b) { return a + b; }, 7, n_threads);
+  int expected_sum = 0;
+  for (int n : expected) {
+    expected_sum += n;
+  }
+  REQUIRE(sum == expected_sum);
+}
+
+TEST_CASE("exceptions of replications are rethrown") {
+  auto model = [](simcpp20::simulation<> &sim, std::uint64_t seed) {
+    sim.timeout(1);
+    sim.run();
+    if (seed == 13) {
+      throw std::runtime_error{"failed"};
+    }
+    return seed;
+  };
+
+  REQUIRE_THROWS_AS(simcpp20::replicate(model, 100, 0, 4),
+                    std::runtime_error);
+  REQUIRE(simcpp20::replicate(model, 10, 0, 4).back() == 9);
+}
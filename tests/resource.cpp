@@ -0,0 +1,208 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+simcpp20::event<> user(simcpp20::simulation<> &sim,
+                       simcpp20::resource<> &res, int id, double duration,
+                       std::vector<int> &order) {
+  co_await res.request();
+  order.push_back(id);
+  co_await sim.timeout(duration);
+  res.release();
+}
+
+TEST_CASE("resource grants requests in order") {
+  simcpp20::simulation<> sim;
+  simcpp20::resource<> res{sim, 2};
+  std::vector<int> order;
+
+  for (int id = 0; id < 5; ++id) {
+    user(sim, res, id, 1, order);
+  }
+
+  sim.run_until(0.5);
+  REQUIRE(order == std::vector<int>{0, 1});
+  REQUIRE(res.available() == 0);
+  REQUIRE(res.queued() == 3);
+
+  sim.run();
+  REQUIRE(order == std::vector<int>{0, 1, 2, 3, 4});
+  REQUIRE(res.available() == 2);
+  REQUIRE(sim.now() == 3);
+}
+
+TEST_CASE("aborted requests are removed immediately") {
+  simcpp20::simulation<> sim;
+  simcpp20::resource<> res{sim, 1};
+
+  auto granted = res.request();
+  auto first = res.request();
+  auto second = res.request();
+  auto third = res.request();
+  REQUIRE(res.queued() == 3);
+
+  second.abort();
+  REQUIRE(res.queued() == 2);
+
+  first.abort();
+  third.abort();
+  REQUIRE(res.queued() == 0);
+
+  res.release();
+  REQUIRE(res.available() == 1);
+
+  auto next = res.request();
+  REQUIRE(next.triggered());
+
+  sim.run();
+  REQUIRE(granted.processed());
+  REQUIRE(first.aborted());
+}
+
+TEST_CASE("priority resource grants smaller priorities first") {
+  simcpp20::simulation<> sim;
+  simcpp20::priority_resource<> res{sim, 1};
+  std::vector<int> order;
+
+  auto granted = res.request(5);
+  for (int priority : {3, 1, 2, 1}) {
+    auto ev = res.request(priority);
+    ev.add_callback([&order, priority](const auto &) {
+      order.push_back(priority);
+    });
+  }
+
+  auto aborted = res.request(0);
+  aborted.abort();
+  REQUIRE(res.queued() == 4);
+
+  for (int i = 0; i < 5; ++i) {
+    res.release();
+  }
+
+  sim.run();
+  REQUIRE(order == std::vector<int>{1, 1, 2, 3});
+  REQUIRE(res.available() == 1);
+}
+
+TEST_CASE("container waits for level and capacity") {
+  simcpp20::simulation<> sim;
+  simcpp20::container<> tank{sim, 10, 5};
+
+  auto get = tank.get(8);
+  REQUIRE(get.pending());
+
+  auto put = tank.put(4);
+  REQUIRE(put.triggered());
+  REQUIRE(get.triggered());
+  REQUIRE(tank.level() == 1);
+
+  auto large = tank.put(10);
+  auto small = tank.put(2);
+  REQUIRE(tank.queued_puts() == 2);
+
+  // the small put waits behind the large put until it is aborted
+  large.abort();
+  REQUIRE(small.triggered());
+  REQUIRE(tank.level() == 3);
+  REQUIRE(tank.queued_puts() == 0);
+}
+
+TEST_CASE("store passes items in order") {
+  simcpp20::simulation<> sim;
+  simcpp20::store<std::string> items{sim, 1};
+
+  auto get = items.get();
+  REQUIRE(get.pending());
+
+  items.put("a");
+  REQUIRE(get.triggered());
+  REQUIRE(get.value() == "a");
+
+  auto put_b = items.put("b");
+  auto put_c = items.put("c");
+  auto put_d = items.put("d");
+  REQUIRE(put_b.triggered());
+  REQUIRE(items.queued_puts() == 2);
+
+  put_c.abort();
+  REQUIRE(items.queued_puts() == 1);
+
+  REQUIRE(items.get().value() == "b");
+  REQUIRE(put_d.triggered());
+  REQUIRE(items.get().value() == "d");
+  REQUIRE(items.size() == 0);
+
+  sim.run();
+}
+
+TEST_CASE("preemptive resource preempts users with larger priorities") {
+  simcpp20::simulation<> sim;
+  simcpp20::preemptive_resource<> res{sim, 1};
+  using preemption = simcpp20::preemptive_resource<>::preemption;
+
+  sim.timeout(2).add_callback([](const auto &) {});
+  sim.run();
+
+  bool preempted = false;
+  auto low = res.request(2, true, [&](const preemption &p) {
+    preempted = true;
+    REQUIRE(p.usage_since_ == 2);
+  });
+  REQUIRE(low.triggered());
+
+  // a request with the same priority does not preempt
+  auto same = res.request(2);
+  REQUIRE(same.pending());
+  REQUIRE(!preempted);
+
+  auto high = res.request(1);
+  REQUIRE(high.triggered());
+  REQUIRE(preempted);
+  REQUIRE(res.queued() == 1);
+
+  // releasing a preempted request does nothing
+  res.release(low);
+  REQUIRE(res.available() == 0);
+
+  res.release(high);
+  REQUIRE(same.triggered());
+  REQUIRE(res.queued() == 0);
+
+  sim.run();
+}
+
+TEST_CASE("preemptive resource orders waiting requests by priority") {
+  simcpp20::simulation<> sim;
+  simcpp20::preemptive_resource<> res{sim, 1};
+  std::vector<int> order;
+
+  auto granted = res.request(0);
+
+  std::vector<simcpp20::event<>> requests;
+  for (int id = 0; id < 6; ++id) {
+    requests.push_back(res.request(id % 3, false));
+    requests.back().add_callback([&order, id](const auto &) {
+      order.push_back(id);
+    });
+  }
+
+  requests[1].abort();
+  REQUIRE(res.change_priority(requests[5], -1));
+  REQUIRE(!res.change_priority(granted, -1));
+  REQUIRE(res.queued() == 5);
+
+  auto current = granted;
+  while (res.queued() > 0) {
+    res.release(current);
+    sim.run();
+    current = requests[static_cast<std::size_t>(order.back())];
+  }
+
+  REQUIRE(order == std::vector<int>{5, 0, 3, 4, 2});
+}
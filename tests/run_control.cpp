@@ -0,0 +1,157 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+
+simcpp20::event<> mm1_customer(simcpp20::simulation<> &sim,
+                               simcpp20::resource<> &server,
+                               simcpp20::time_weighted<> &in_system,
+                               std::mt19937_64 &gen) {
+  in_system.add(1);
+  co_await server.request();
+  co_await sim.timeout(std::exponential_distribution<>{1}(gen));
+  server.release();
+  in_system.add(-1);
+}
+
+simcpp20::event<> mm1_source(simcpp20::simulation<> &sim,
+                             simcpp20::resource<> &server,
+                             simcpp20::time_weighted<> &in_system,
+                             std::mt19937_64 &gen) {
+  while (true) {
+    co_await sim.timeout(std::exponential_distribution<>{0.5}(gen));
+    mm1_customer(sim, server, in_system, gen);
+  }
+}
+
+TEST_CASE("student t quantiles are close to the tabulated values") {
+  using simcpp20::detail::student_t_quantile;
+  REQUIRE(std::abs(student_t_quantile(0.975, 1) - 12.706) < 1e-3);
+  REQUIRE(std::abs(student_t_quantile(0.975, 2) - 4.303) < 1e-3);
+  REQUIRE(std::abs(student_t_quantile(0.975, 3) - 3.182) < 0.02);
+  REQUIRE(std::abs(student_t_quantile(0.975, 10) - 2.228) < 0.005);
+  REQUIRE(std::abs(student_t_quantile(0.975, 30) - 2.042) < 0.005);
+  REQUIRE(std::abs(student_t_quantile(0.995, 20) - 2.845) < 0.005);
+}
+
+TEST_CASE("tallies compute confidence intervals of the mean") {
+  simcpp20::tally t;
+  REQUIRE(std::isinf(t.half_width()));
+
+  for (double x : {2, 4, 4, 4, 5, 5, 7, 9}) {
+    t.add(x);
+  }
+
+  // t(0.975, 7) = 2.365
+  double expected = 2.365 * std::sqrt(32. / 7 / 8);
+  REQUIRE(std::abs(t.half_width() - expected) < 0.01);
+  REQUIRE(std::abs(t.relative_half_width() - expected / 5) < 0.01);
+  REQUIRE(t.half_width(0.99) > t.half_width(0.9));
+}
+
+TEST_CASE("run control stops once the batch means are precise enough") {
+  simcpp20::simulation<> sim;
+  simcpp20::resource<> server{sim, 1};
+  simcpp20::time_weighted<> in_system{sim};
+  std::mt19937_64 gen{42};
+  mm1_source(sim, server, in_system, gen);
+
+  sim.run_until(100);
+  in_system.reset();
+
+  simcpp20::run_control control{sim, 100.0};
+  auto &batches = control.watch(in_system, 0.1);
+  REQUIRE(control.run_until(1e6));
+
+  REQUIRE(control.batches() >= 10);
+  REQUIRE(batches.count() == control.batches());
+  REQUIRE(batches.relative_half_width() <= 0.1);
+  REQUIRE(sim.now() == 100 + 100.0 * static_cast<double>(control.batches()));
+  REQUIRE(sim.now() < 1e6);
+
+  // the mean number in system of an M/M/1 queue with utilization 0.5 is 1
+  REQUIRE(std::abs(batches.mean() - 1) < 0.3);
+
+  // a converged run does not continue
+  auto n = control.batches();
+  REQUIRE(control.run_until(1e6));
+  REQUIRE(control.batches() == n);
+
+  // a statistic watched later needs its own batches
+  auto &zeros = control.watch([] { return 0.0; }, 0.1);
+  REQUIRE(!control.converged());
+  REQUIRE(control.run_until(1e6));
+  REQUIRE(zeros.count() == 10);
+  REQUIRE(control.batches() >= n + 10);
+}
+
+TEST_CASE("run control stops at the horizon") {
+  simcpp20::simulation<> sim;
+  simcpp20::tally waits;
+  int i = 0;
+
+  simcpp20::run_control control{sim, 10.0, 0.95, 5};
+  auto &batches = control.watch(
+      [&] {
+        ++i;
+        return i % 2 == 0 ? 1.0 : 100.0;
+      },
+      0.01);
+  control.watch(waits, 1);
+
+  REQUIRE(!control.run_until(55));
+  REQUIRE(control.batches() == 5);
+  REQUIRE(batches.count() == 5);
+  REQUIRE(sim.now() == 55);
+  REQUIRE(!control.converged());
+}
+
+TEST_CASE("replications stop once the results are precise enough") {
+  auto model = [](simcpp20::simulation<> &sim, std::uint64_t seed) {
+    std::mt19937_64 gen{seed};
+    sim.run_until(1);
+    return std::normal_distribution<>{10, 1}(gen);
+  };
+
+  auto results = simcpp20::replicate_until(model, 0.01, 0.95, 5, 1000, 0, 3);
+  REQUIRE(results.size() >= 5);
+  REQUIRE(results.size() < 1000);
+
+  simcpp20::tally t;
+  for (auto result : results) {
+    t.add(result);
+  }
+  REQUIRE(t.relative_half_width() <= 0.01);
+
+  // the results do not depend on the number of threads
+  REQUIRE(simcpp20::replicate_until(model, 0.01, 0.95, 5, 1000, 0, 1) ==
+          results);
+  REQUIRE(simcpp20::replicate_until(model, 0.01, 0.95, 5, 1000, 0, 8) ==
+          results);
+
+  // the target is not reached
+  REQUIRE(simcpp20::replicate_until(model, 1e-6, 0.95, 5, 20, 0, 3).size() ==
+          20);
+}
+
+struct mean_wait {
+  explicit mean_wait(double value) : value_{value} {}
+
+  explicit operator double() const { return value_; }
+
+  double value_;
+};
+
+TEST_CASE("replications may return results without a default constructor") {
+  auto model = [](simcpp20::simulation<> &, std::uint64_t seed) {
+    return mean_wait{10 + static_cast<double>(seed % 2)};
+  };
+
+  auto results = simcpp20::replicate_until(model, 0.5, 0.95, 5, 100, 0, 2);
+  REQUIRE(results.size() == 5);
+}
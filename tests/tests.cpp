@@ -83,3 +83,48 @@ TEST_CASE("boolean logic") {
     REQUIRE(finished);
   }
 }
+
+TEST_CASE("conditions") {
+  simcpp20::simulation<> sim;
+
+  SECTION("all_of waits for a child given twice only once") {
+    auto ev_a = sim.timeout(1);
+    auto ev = ev_a & ev_a;
+    bool finished = false;
+    awaiter(sim, ev, 1, finished);
+
+    sim.run();
+
+    REQUIRE(finished);
+  }
+
+  SECTION("all_of is not triggered when one event is aborted") {
+    auto ev_a = sim.event();
+    auto ev = ev_a & sim.timeout(1);
+    ev_a.abort();
+
+    sim.run();
+
+    REQUIRE(ev.pending());
+  }
+
+  SECTION("conditions outlive their children") {
+    auto ev = sim.any_of({sim.event(), sim.event()});
+
+    sim.run();
+
+    REQUIRE(ev.pending());
+  }
+
+  SECTION("conditions can be nested") {
+    auto ev_a = sim.timeout(1);
+    auto ev_b = sim.timeout(2);
+    auto ev = (ev_a | sim.event()) & (ev_b | sim.event());
+    bool finished = false;
+    awaiter(sim, ev, 2, finished);
+
+    sim.run();
+
+    REQUIRE(finished);
+  }
+}
@@ -0,0 +1,70 @@
+// Copyright © 2021 Felix Schütz.
+// Licensed under the MIT license. See the LICENSE file for details.
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "catch2/catch_test_macros.hpp"
+#include "fschuetz04/simcpp20.hpp"
+#include "fschuetz04/simcpp20/trace_file.hpp"
+
+struct trace_file_policy : simcpp20::default_policy {
+  using observer = simcpp20::trace_observer<simcpp20::trace_file_writer>;
+};
+
+simcpp20::event<double, trace_file_policy>
+tagged(simcpp20::simulation<double, trace_file_policy> &sim, int n) {
+  for (int i = 0; i < n; ++i) {
+    co_await sim.timeout(1);
+    sim.observer().mark(sim.now(), static_cast<std::uint32_t>(i));
+  }
+}
+
+TEST_CASE("trace files are written and mapped") {
+  auto path = (std::filesystem::temp_directory_path() / "simcpp20_trace.bin")
+                  .string();
+
+  {
+    simcpp20::simulation<double, trace_file_policy> sim;
+    REQUIRE(sim.observer().sink().open(path.c_str()));
+
+    // more records than the buffer of the writer holds
+    tagged(sim, 10'000);
+    sim.run();
+  }
+
+  simcpp20::trace_file_reader reader;
+  REQUIRE(reader.open(path.c_str()));
+
+  std::size_t n_marks = 0;
+  double last = 0;
+  for (const auto &record : reader) {
+    if (record.kind_ == simcpp20::trace_kind::user) {
+      REQUIRE(record.value_ == n_marks);
+      REQUIRE(record.time_ == static_cast<double>(n_marks + 1));
+      ++n_marks;
+    }
+
+    REQUIRE(record.time_ >= last);
+    if (record.kind_ != simcpp20::trace_kind::schedule) {
+      last = record.time_;
+    }
+  }
+
+  REQUIRE(n_marks == 10'000);
+  REQUIRE(reader.records().front().kind_ == simcpp20::trace_kind::schedule);
+  reader.close();
+  REQUIRE(reader.size() == 0);
+
+  // files without a valid header are rejected
+  {
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    std::fputs("not a trace", file);
+    std::fclose(file);
+  }
+  REQUIRE(!reader.open(path.c_str()));
+  REQUIRE(!reader.open((path + ".missing").c_str()));
+
+  std::filesystem::remove(path);
+}